@@ -0,0 +1,282 @@
+#ifndef JSONS_BENCHMARK_H_
+#define JSONS_BENCHMARK_H_
+
+#include <algorithm>
+#include <cstring>
+#include <jsons.h>
+
+/*
+ * Measures the throughput of the reader and writer, for a set of documents
+ * resembling the usual JSON benchmark corpus and several maximum token
+ * lengths. This is shared by the sketch (on the target) and the host
+ * program in test/benchmark.cpp, which provide the clock and print the
+ * results.
+ *
+ * The documents are generated on the fly by repeating a record within a
+ * list, so they can be much larger than the available memory.
+ */
+
+struct Corpus {
+  const char* name;
+  const char* record;
+  size_t count;
+};
+
+// short excerpts in the spirit of twitter.json, canada.json etc.
+static const Corpus CORPORA[] = {
+  {"twitter", "{\"id\":505874924095815681,\"text\":\"@aym0566x \\u540d\\u524d:\\u524d\\u7530\\u3042\\u3086\\u307f \\\"RT\\\"\",\"user\":{\"id\":1186275104,\"screen_name\":\"ayuu0123\",\"followers_count\":262,\"verified\":false,\"lang\":\"ja\"},\"retweet_count\":0,\"favorited\":false,\"geo\":null,\"entities\":{\"hashtags\":[],\"user_mentions\":[{\"screen_name\":\"aym0566x\",\"indices\":[0,9]}]}}", 200},
+  {"canada", "[[-65.613616999999977,43.420273000000009],[-65.619720000000029,43.418052999999986],[-65.625,43.421379000000059],[-65.636123999999882,43.449714999999969],[-65.633056999999951,43.474709000000132]]", 400},
+  {"nested", "[[[[[[[[[[[[[[[[{\"a\":[[[[{\"b\":[1,true,null]}]]]]}]]]]]]]]]]]]]]]]", 400},
+  {"strings", "{\"name\":\"Lorem ipsum dolor sit amet, consectetur adipiscing elit, sed do eiusmod tempor incididunt ut labore\",\"escaped\":\"line\\nbreak \\\"quoted\\\" \\\\ back\\tslash \\u00e4\\u00f6\\u00fc\",\"short\":\"x\"}", 200},
+  {"numbers", "[0,-1,42,1234567,-98765432,3.14159,-0.000123,6.02214076e23,1E-7,2147483647,-2147483648,100.5]", 400},
+};
+
+/**
+ * Input which provides a list of the record of a corpus, repeated count times.
+ */
+class CorpusInput final {
+  const Corpus& _corpus;
+  const size_t _recordLength;
+  size_t _record; // index of the current record
+  size_t _position; // position within the current record, including the separator before it
+  bool _closed;
+
+  size_t segmentLength() const {
+    return _recordLength + 1u; // with '[' or ',' before it
+  }
+
+  char charAt(size_t position) const {
+    if (position == 0u) {
+      return _record == 0u ? '[' : ',';
+    }
+    return _corpus.record[position - 1u];
+  }
+
+public:
+  CorpusInput(const Corpus& corpus) : _corpus(corpus), _recordLength(strlen(corpus.record)), _record(0u), _position(0u), _closed(false) {}
+
+  size_t length() const {
+    return _corpus.count * segmentLength() + 1u;
+  }
+
+  size_t available() const {
+    if (_record < _corpus.count) {
+      return (_corpus.count - _record) * segmentLength() - _position + 1u;
+    }
+    return _closed ? 0u : 1u;
+  }
+
+  char read() {
+    char c;
+    return readString(&c, 1u) == 1u ? c : '\0';
+  }
+
+  size_t readString(char* buffer, size_t length) {
+    size_t count = 0u;
+    while (count < length && _record < _corpus.count) {
+      if (_position == 0u) {
+        buffer[count++] = charAt(0u);
+        _position = 1u;
+        continue;
+      }
+      const size_t chunk = std::min(length - count, segmentLength() - _position);
+      memcpy(buffer + count, _corpus.record + _position - 1u, chunk);
+      count += chunk;
+      _position += chunk;
+      if (_position == segmentLength()) {
+        _record += 1u;
+        _position = 0u;
+      }
+    }
+    if (count < length && _record == _corpus.count && !_closed) {
+      buffer[count++] = ']';
+      _closed = true;
+    }
+    return count;
+  }
+};
+
+/** Result of benchmarking one operation on a corpus. */
+struct Result {
+  const char* what;
+  const Corpus& corpus;
+  size_t maxTokenLength;
+  size_t bytes;
+  size_t values; // 0 if not counted
+  unsigned long micros;
+  bool failed;
+};
+
+/** Returns the current time in microseconds. */
+using Clock = unsigned long (*)();
+
+using Report = void (*)(const Result& result);
+
+/** Reads all values below the given one, returns the number of values read. */
+static size_t readAll(jsons::Value& value) {
+  size_t values = 1u;
+  switch (value.type()) {
+    case jsons::ValueType::Integer:
+      value.asInteger64();
+      break;
+    case jsons::ValueType::Decimal:
+      value.asDouble();
+      break;
+    case jsons::ValueType::String:
+      for (auto& fragment : value.asStringFragments()) {
+        (void) fragment;
+      }
+      break;
+    case jsons::ValueType::List:
+      for (auto& element : value.asList()) {
+        values += readAll(element);
+      }
+      break;
+    case jsons::ValueType::Object:
+      for (auto& property : value.asObject()) {
+        values += readAll(property);
+      }
+      break;
+    default:
+      break;
+  }
+  return values;
+}
+
+/**
+ * Copies all values below the given one to the writer, returns the number
+ * of values copied. Strings longer than the maximum token length are
+ * written as empty strings.
+ */
+static size_t copyAll(jsons::Value& value, jsons::IWriter& writer) {
+  size_t values = 1u;
+  switch (value.type()) {
+    case jsons::ValueType::Null:
+      writer.null();
+      break;
+    case jsons::ValueType::Boolean:
+      writer.boolean(value.asBoolean());
+      break;
+    case jsons::ValueType::Integer:
+      writer.number(value.asInteger64());
+      break;
+    case jsons::ValueType::Decimal:
+      writer.number(value.asDouble());
+      break;
+    case jsons::ValueType::String:
+      if (value.isLongString()) {
+        writer.string("");
+        value.skip();
+      } else {
+        writer.string(value.asString());
+      }
+      break;
+    case jsons::ValueType::List:
+      writer.openList();
+      for (auto& element : value.asList()) {
+        values += copyAll(element, writer);
+      }
+      writer.close();
+      break;
+    case jsons::ValueType::Object:
+      writer.openObject();
+      for (auto& property : value.asObject()) {
+        writer.property(property.name());
+        values += copyAll(property, writer);
+      }
+      writer.close();
+      break;
+    default:
+      break;
+  }
+  return values;
+}
+
+/** Handler for jsons::parse() which only counts the values. */
+struct CountingHandler : jsons::EventHandler {
+  size_t values = 0u;
+
+  void onNull() { values += 1u; }
+  void onBoolean(bool) { values += 1u; }
+  void onNumber(const jsons::Number&) { values += 1u; }
+  void onString(const toolbox::strref&) { values += 1u; }
+  void onOpenList() { values += 1u; }
+  void onOpenObject() { values += 1u; }
+};
+
+template<size_t max_token_length>
+void benchmarkReader(const Corpus& corpus, Clock clock, Report report) {
+  CorpusInput input {corpus};
+  const size_t bytes = input.length();
+  auto reader = jsons::makeReader<CorpusInput, max_token_length>(input);
+  const unsigned long start = clock();
+  size_t values;
+  {
+    auto root = reader.begin();
+    values = readAll(root);
+  }
+  reader.end();
+  const unsigned long duration = clock() - start;
+  report({"read", corpus, max_token_length, bytes, values, duration, reader.failed()});
+}
+
+template<size_t max_token_length>
+void benchmarkEvents(const Corpus& corpus, Clock clock, Report report) {
+  CorpusInput input {corpus};
+  const size_t bytes = input.length();
+  CountingHandler handler;
+  const unsigned long start = clock();
+  auto parser = jsons::parse<max_token_length>(input, handler);
+  const unsigned long duration = clock() - start;
+  report({"events", corpus, max_token_length, bytes, handler.values, duration, parser.failed()});
+}
+
+template<size_t max_token_length>
+void benchmarkValidate(const Corpus& corpus, Clock clock, Report report) {
+  CorpusInput input {corpus};
+  const size_t bytes = input.length();
+  const unsigned long start = clock();
+  auto parser = jsons::validate<max_token_length>(input);
+  const unsigned long duration = clock() - start;
+  report({"validate", corpus, max_token_length, bytes, 0u, duration, parser.failed()});
+}
+
+template<size_t max_token_length>
+void benchmarkCopy(const Corpus& corpus, Clock clock, Report report) {
+  CorpusInput input {corpus};
+  jsons::SizeCounter output;
+  auto reader = jsons::makeReader<CorpusInput, max_token_length>(input);
+  auto writer = jsons::makeWriter<jsons::SizeCounter, 64u, 40u>(output);
+  const unsigned long start = clock();
+  size_t values;
+  {
+    auto root = reader.begin();
+    values = copyAll(root, writer);
+  }
+  reader.end();
+  writer.end();
+  const unsigned long duration = clock() - start;
+  report({"copy", corpus, max_token_length, output.size(), values, duration, reader.failed() || writer.failed()});
+}
+
+template<size_t max_token_length>
+void benchmarkTranscode(const Corpus& corpus, Clock clock, Report report) {
+  CorpusInput input {corpus};
+  jsons::SizeCounter output;
+  auto writer = jsons::makeWriter<jsons::SizeCounter, 64u, 40u>(output);
+  const unsigned long start = clock();
+  auto result = jsons::transcode<max_token_length>(input, writer);
+  const unsigned long duration = clock() - start;
+  report({"transcode", corpus, max_token_length, output.size(), 0u, duration, result.failed()});
+}
+
+template<size_t max_token_length>
+void benchmark(const Corpus& corpus, Clock clock, Report report) {
+  benchmarkReader<max_token_length>(corpus, clock, report);
+  benchmarkEvents<max_token_length>(corpus, clock, report);
+  benchmarkValidate<max_token_length>(corpus, clock, report);
+  benchmarkCopy<max_token_length>(corpus, clock, report);
+  benchmarkTranscode<max_token_length>(corpus, clock, report);
+}
+
+#endif
@@ -0,0 +1,50 @@
+#include <Arduino.h>
+
+#include <jsons.h>
+#include "Benchmark.h"
+
+/*
+ * Runs the benchmarks of Benchmark.h on the target and prints the results
+ * to the serial port.
+ */
+
+static unsigned long now() {
+  return micros();
+}
+
+static void printResult(const Result& result) {
+  Serial.print(result.what);
+  Serial.print('\t');
+  Serial.print(result.corpus.name);
+  Serial.print('\t');
+  Serial.print(result.maxTokenLength);
+  Serial.print('\t');
+  if (result.failed) {
+    Serial.println("FAILED");
+    return;
+  }
+  Serial.print(result.micros > 0u ? static_cast<float>(result.bytes) / result.micros : 0.0f, 3); // bytes per microsecond = MB/s
+  Serial.print(" MB/s\t");
+  if (result.values == 0u) {
+    Serial.println("-"); // not counted
+    return;
+  }
+  Serial.print(static_cast<float>(result.micros) * 1000.0f / result.values, 1);
+  Serial.println(" ns/value");
+}
+
+void setup() {
+  Serial.begin(115200);
+  while (!Serial) {}
+
+  Serial.println();
+  Serial.println("what\tcorpus\tmax_token_length\tthroughput\ttime per value");
+  for (const Corpus& corpus : CORPORA) {
+    benchmark<32u>(corpus, &now, &printResult);
+    benchmark<64u>(corpus, &now, &printResult);
+    benchmark<128u>(corpus, &now, &printResult);
+  }
+}
+
+void loop() {
+}
@@ -5,5 +5,10 @@
 #include "jsons/Version.h"
 #include "jsons/Reader.h"
 #include "jsons/Writer.h"
+#include "jsons/Selector.h"
+#include "jsons/EventParser.h"
+#include "jsons/Transcoder.h"
+#include "jsons/Splitter.h"
+#include "jsons/Binding.h"
 
 #endif
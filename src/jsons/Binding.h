@@ -0,0 +1,290 @@
+#ifndef JSONS_BINDING_H_
+#define JSONS_BINDING_H_
+
+#include <limits>
+#include <type_traits>
+#include "Reader.h"
+#include "Writer.h"
+
+/**
+ * Binds the fields of a struct to the properties of an object with the
+ * same names, e.g.
+ *
+ *   struct Config {
+ *     int32_t interval;
+ *     char ssid[33];
+ *     Sensor sensors[4];
+ *   };
+ *   JSONS_BIND(Config, interval, ssid, sensors)
+ *
+ * so it can be read with jsons::read(value, config) and written with
+ * jsons::write(writer, config). It must be used in the namespace of the
+ * struct, after the bindings of the structs of its fields.
+ *
+ * Fields can be bool, integers, floating point numbers, toolbox::Decimal,
+ * char arrays for strings, arrays of any of these and other bound structs.
+ * At most 16 fields can be bound.
+ *
+ * Reading and writing the fields is generated from templates at compile
+ * time, only the key table of the names is sorted at runtime (once, see
+ * FieldKeys).
+ */
+#define JSONS_BIND(type, ...) \
+  struct JsonsBinding_##type { \
+    static const size_t FIELDS = JSONS_BIND_COUNT(__VA_ARGS__); \
+    static const ::jsons::FieldKeys<FIELDS>& keys() { \
+      static const char* const NAMES[] = {JSONS_BIND_EACH(JSONS_BIND_NAME, __VA_ARGS__)}; \
+      static const ::jsons::FieldKeys<FIELDS> KEYS {NAMES}; \
+      return KEYS; \
+    } \
+    template<typename Tokenizer> \
+    static void read(::jsons::BasicValue<Tokenizer>& value, type& object, size_t field) { \
+      switch (field) { \
+        JSONS_BIND_EACH(JSONS_BIND_READ, __VA_ARGS__) \
+        default: break; \
+      } \
+    } \
+    static void write(::jsons::IWriter& writer, const type& object) { \
+      JSONS_BIND_EACH(JSONS_BIND_WRITE, __VA_ARGS__) \
+    } \
+  }; \
+  inline JsonsBinding_##type jsonsBinding(const type*) { return {}; }
+
+// the index passed to the macros counts down from the last field
+
+#define JSONS_BIND_NAME(index, field) #field,
+#define JSONS_BIND_READ(index, field) case FIELDS - 1u - index: ::jsons::read(value, object.field); break;
+#define JSONS_BIND_WRITE(index, field) writer.property(#field); ::jsons::write(writer, object.field);
+
+#define JSONS_BIND_CONCAT_(a, b) a##b
+#define JSONS_BIND_CONCAT(a, b) JSONS_BIND_CONCAT_(a, b)
+#define JSONS_BIND_COUNT_(_1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, _13, _14, _15, _16, count, ...) count
+#define JSONS_BIND_COUNT(...) JSONS_BIND_COUNT_(__VA_ARGS__, 16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+#define JSONS_BIND_EACH(macro, ...) JSONS_BIND_CONCAT(JSONS_BIND_EACH_, JSONS_BIND_COUNT(__VA_ARGS__))(macro, __VA_ARGS__)
+
+#define JSONS_BIND_EACH_1(m, f) m(0u, f)
+#define JSONS_BIND_EACH_2(m, f, ...) m(1u, f) JSONS_BIND_EACH_1(m, __VA_ARGS__)
+#define JSONS_BIND_EACH_3(m, f, ...) m(2u, f) JSONS_BIND_EACH_2(m, __VA_ARGS__)
+#define JSONS_BIND_EACH_4(m, f, ...) m(3u, f) JSONS_BIND_EACH_3(m, __VA_ARGS__)
+#define JSONS_BIND_EACH_5(m, f, ...) m(4u, f) JSONS_BIND_EACH_4(m, __VA_ARGS__)
+#define JSONS_BIND_EACH_6(m, f, ...) m(5u, f) JSONS_BIND_EACH_5(m, __VA_ARGS__)
+#define JSONS_BIND_EACH_7(m, f, ...) m(6u, f) JSONS_BIND_EACH_6(m, __VA_ARGS__)
+#define JSONS_BIND_EACH_8(m, f, ...) m(7u, f) JSONS_BIND_EACH_7(m, __VA_ARGS__)
+#define JSONS_BIND_EACH_9(m, f, ...) m(8u, f) JSONS_BIND_EACH_8(m, __VA_ARGS__)
+#define JSONS_BIND_EACH_10(m, f, ...) m(9u, f) JSONS_BIND_EACH_9(m, __VA_ARGS__)
+#define JSONS_BIND_EACH_11(m, f, ...) m(10u, f) JSONS_BIND_EACH_10(m, __VA_ARGS__)
+#define JSONS_BIND_EACH_12(m, f, ...) m(11u, f) JSONS_BIND_EACH_11(m, __VA_ARGS__)
+#define JSONS_BIND_EACH_13(m, f, ...) m(12u, f) JSONS_BIND_EACH_12(m, __VA_ARGS__)
+#define JSONS_BIND_EACH_14(m, f, ...) m(13u, f) JSONS_BIND_EACH_13(m, __VA_ARGS__)
+#define JSONS_BIND_EACH_15(m, f, ...) m(14u, f) JSONS_BIND_EACH_14(m, __VA_ARGS__)
+#define JSONS_BIND_EACH_16(m, f, ...) m(15u, f) JSONS_BIND_EACH_15(m, __VA_ARGS__)
+
+namespace jsons {
+inline namespace JSONS_STATS_NAMESPACE {
+
+/**
+ * Key table of the fields of a bound struct (see JSONS_BIND), which sorts
+ * the names of the fields for the KeyTable and maps its keys back to the
+ * fields. The names are sorted at runtime, once when the binding is first
+ * used (as its keys() are a function-local static).
+ */
+template<size_t field_count>
+class FieldKeys final {
+  const char* _names[field_count]; // sorted
+  size_t _fields[field_count]; // index of the field of each name
+  KeyTable _table;
+
+public:
+  FieldKeys(const char* const (&names)[field_count]) : _names(), _fields(), _table(_names) {
+    // insertion sort, as there are only a few fields
+    for (size_t i = 0; i < field_count; ++i) {
+      size_t j = i;
+      while (j > 0 && strcmp(names[i], _names[j - 1]) < 0) {
+        _names[j] = _names[j - 1];
+        _fields[j] = _fields[j - 1];
+        --j;
+      }
+      _names[j] = names[i];
+      _fields[j] = i;
+    }
+  }
+
+  const KeyTable& table() const { return _table; }
+
+  size_t field(size_t key) const { return key < field_count ? _fields[key] : KeyTable::UNKNOWN; }
+};
+
+template<typename T>
+using BindingOf = decltype(jsonsBinding(static_cast<const T*>(nullptr)));
+
+/*
+ * Reading fields from values. A null value leaves the field as it is, a
+ * value of another type than the field aborts reading.
+ */
+
+template<typename Tokenizer>
+bool readable(BasicValue<Tokenizer>& value, ValueType type) {
+  if (value.type() == type) {
+    return true;
+  }
+  if (value.type() != ValueType::Null) {
+    value.abort(F("Unexpected type of value for field."));
+  }
+  return false;
+}
+
+template<typename Tokenizer>
+void read(BasicValue<Tokenizer>& value, bool& field) {
+  if (readable(value, ValueType::Boolean)) {
+    field = value.asBoolean().get();
+  }
+}
+
+template<typename Tokenizer, typename T, typename std::enable_if<std::is_integral<T>::value && std::is_signed<T>::value, int>::type = 0>
+void read(BasicValue<Tokenizer>& value, T& field) {
+  if (!readable(value, ValueType::Integer)) {
+    return;
+  }
+  auto number = value.asInteger64();
+  if (!number) {
+    return; // already aborted as out of range
+  }
+  const int64_t integer = number.get();
+  if (integer < static_cast<int64_t>(std::numeric_limits<T>::min()) || integer > static_cast<int64_t>(std::numeric_limits<T>::max())) {
+    value.abort(F("Number out of range."));
+    return;
+  }
+  field = static_cast<T>(integer);
+}
+
+template<typename Tokenizer, typename T, typename std::enable_if<std::is_integral<T>::value && std::is_unsigned<T>::value && !std::is_same<T, bool>::value, int>::type = 0>
+void read(BasicValue<Tokenizer>& value, T& field) {
+  if (!readable(value, ValueType::Integer)) {
+    return;
+  }
+  auto number = value.asUnsigned64();
+  if (!number) {
+    return; // already aborted as out of range
+  }
+  if (number.get() > static_cast<uint64_t>(std::numeric_limits<T>::max())) {
+    value.abort(F("Number out of range."));
+    return;
+  }
+  field = static_cast<T>(number.get());
+}
+
+template<typename Tokenizer, typename T, typename std::enable_if<std::is_floating_point<T>::value, int>::type = 0>
+void read(BasicValue<Tokenizer>& value, T& field) {
+  if (value.type() == ValueType::Integer || readable(value, ValueType::Decimal)) {
+    field = static_cast<T>(value.asDouble().get());
+  }
+}
+
+template<typename Tokenizer>
+void read(BasicValue<Tokenizer>& value, toolbox::Decimal& field) {
+  if (value.type() == ValueType::Integer || readable(value, ValueType::Decimal)) {
+    auto decimal = value.asDecimal();
+    if (decimal) {
+      field = decimal.get();
+    }
+  }
+}
+
+/** Reads a string, which must fit into the field including the terminating zero. */
+template<typename Tokenizer, size_t size>
+void read(BasicValue<Tokenizer>& value, char (&field)[size]) {
+  if (!readable(value, ValueType::String)) {
+    return;
+  }
+  if (value.isLongString()) {
+    value.abort(F("String too long for field."));
+    return;
+  }
+  const toolbox::strref string = value.asString().get();
+  const size_t length = string.length();
+  if (length >= size) {
+    value.abort(F("String too long for field."));
+    return;
+  }
+  memcpy(field, string.cstr(), length + 1);
+}
+
+/** Reads the elements of a list, elements missing in the list are left as they are. */
+template<typename Tokenizer, typename T, size_t size>
+void read(BasicValue<Tokenizer>& value, T (&field)[size]) {
+  if (!readable(value, ValueType::List)) {
+    return;
+  }
+  size_t index = 0;
+  for (auto& element : value.asList()) {
+    if (index == size) {
+      element.abort(F("Too many elements for field."));
+      break;
+    }
+    read(element, field[index++]);
+  }
+}
+
+/**
+ * Reads the properties of an object into the fields of a bound struct.
+ * Properties without a field are skipped structurally (see Value::skip()).
+ */
+template<typename Tokenizer, typename T, typename Binding = BindingOf<T>>
+void read(BasicValue<Tokenizer>& value, T& object) {
+  if (!readable(value, ValueType::Object)) {
+    return;
+  }
+  const auto& keys = Binding::keys();
+  for (auto& property : value.asObject(keys.table())) {
+    Binding::read(property, object, keys.field(property.key()));
+  }
+}
+
+/* Writing fields as values. */
+
+inline void write(IWriter& writer, bool field) {
+  writer.boolean(field);
+}
+
+/** Integers of any size, see IWriter::number(). */
+template<typename T, typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, bool>::value, int>::type = 0>
+void write(IWriter& writer, T field) {
+  writer.number(field);
+}
+
+template<typename T, typename std::enable_if<std::is_floating_point<T>::value, int>::type = 0>
+void write(IWriter& writer, T field) {
+  writer.number(toolbox::Maybe<double>(field));
+}
+
+inline void write(IWriter& writer, const toolbox::Decimal& field) {
+  writer.number(toolbox::Maybe<const toolbox::Decimal&>(field));
+}
+
+template<size_t size>
+void write(IWriter& writer, const char (&field)[size]) {
+  writer.string(toolbox::Maybe<const char*>(field));
+}
+
+template<typename T, size_t size>
+void write(IWriter& writer, const T (&field)[size]) {
+  writer.openList();
+  for (const T& element : field) {
+    write(writer, element);
+  }
+  writer.close();
+}
+
+/** Writes a bound struct as an object with a property for each field. */
+template<typename T, typename Binding = BindingOf<T>>
+void write(IWriter& writer, const T& object) {
+  writer.openObject();
+  Binding::write(writer, object);
+  writer.close();
+}
+
+}
+
+}
+
+#endif
@@ -0,0 +1,539 @@
+#ifndef JSONS_EVENTPARSER_H_
+#define JSONS_EVENTPARSER_H_
+
+#include "Reader.h"
+
+namespace jsons {
+inline namespace JSONS_STATS_NAMESPACE {
+
+/**
+ * Handler for the events of an EventParser, which does nothing. Handlers can
+ * derive from it and only hide the events they are interested in, as they
+ * are called on the concrete handler type (so nothing is virtual).
+ *
+ * Strings and numbers are only valid during the call. Strings longer than
+ * the maximum token length are reported in fragments, i.e. onStringFragment()
+ * for all but the last one, which is reported by onString().
+ */
+struct EventHandler {
+  void onNull() {}
+  void onBoolean(bool) {}
+  void onNumber(const Number&) {}
+  void onStringFragment(const toolbox::strref&) {}
+  void onString(const toolbox::strref&) {}
+  void onKey(const toolbox::strref&) {}
+  void onOpenList() {}
+  void onCloseList() {}
+  void onOpenObject() {}
+  void onCloseObject() {}
+};
+
+enum struct ParseStatus { NeedMoreData, Done, Failed };
+
+/**
+ * Parser which reports a document as a sequence of events to a handler (see
+ * EventHandler) instead of returning values. It runs as a flat loop, with
+ * the nesting tracked by the structures of the tokenizer.
+ *
+ * Parsing can stop at any point where the buffered input runs out and
+ * resume later from the same state (see PushParser). The input is only
+ * considered to be at its end once finished() is set, so an input which has
+ * nothing available right now does not fail the document.
+ *
+ * Property names must fit into max_token_length characters.
+ *
+ * With raw_strings, strings and property names are reported as they are in
+ * the document (i.e. with their escape sequences), which are only checked
+ * (together with control characters, which must be escaped).
+ */
+template<typename Input, typename Handler, size_t max_token_length, size_t max_depth = 32u, bool raw_strings = false>
+class EventParser {
+public:
+  static const size_t MAX_TOKEN_LENGTH = max_token_length;
+  static const size_t MAX_DEPTH = max_depth;
+  static const bool RAW_STRINGS = raw_strings;
+
+private:
+  /** What the parser expects at the current position of the input. */
+  enum struct State : uint8_t {
+    Value,
+    FirstElement, // value or ']'
+    FirstProperty, // property name or '}'
+    NextProperty, // property name
+    String, // contents of a string value, after its leading '"'
+    Name, // contents of a property name, after its leading '"'
+    Colon,
+    AfterValue, // ',' or the end of the list or object
+    Done
+  };
+
+  Tokenizer<Input, MAX_TOKEN_LENGTH, ITokenizer, MAX_DEPTH> _tokenizer;
+  Handler& _handler;
+  State _state;
+  bool _finished;
+
+  /**
+   * Returns true if there is no more buffered input at the current position,
+   * i.e. parsing has to wait for more. Aborts if the input is finished.
+   */
+  bool exhausted() {
+    if (*_tokenizer.current() != '\0') {
+      return false;
+    }
+    if (_finished) {
+      _tokenizer.abort(F("Unexpected end of input."));
+    }
+    return true;
+  }
+
+  /**
+   * Returns true if the current token reaches the end of the buffered input
+   * and may continue with more input. The token is then put back to be read
+   * again once there is more input.
+   */
+  bool incomplete() {
+    if (_tokenizer.stopChar() != '\0' || _finished || strlen(_tokenizer.current()) >= MAX_TOKEN_LENGTH) {
+      return false;
+    }
+    _tokenizer.truncate(0);
+    return true;
+  }
+
+  /** Returns false if the value needs more input. */
+  bool parseValue() {
+    switch (_tokenizer.peek("ntf\"-0123456789[{")) {
+      case 'n':
+        _tokenizer.nextUntil(chars::VALUE_DELIMITERS);
+        if (incomplete()) {
+          return false;
+        }
+        if (strcmp(_tokenizer.current(), "null") == 0) {
+          _tokenizer.pop();
+          _handler.onNull();
+          _state = State::AfterValue;
+        } else {
+          _tokenizer.abort(F("Expected 'null' value."));
+        }
+        return true;
+      case 't':
+      case 'f':
+        _tokenizer.nextUntil(chars::VALUE_DELIMITERS);
+        if (incomplete()) {
+          return false;
+        }
+        if (strcmp(_tokenizer.current(), "true") == 0) {
+          _tokenizer.pop();
+          _handler.onBoolean(true);
+          _state = State::AfterValue;
+        } else if (strcmp(_tokenizer.current(), "false") == 0) {
+          _tokenizer.pop();
+          _handler.onBoolean(false);
+          _state = State::AfterValue;
+        } else {
+          _tokenizer.abort(F("Expected boolean 'true' or 'false'."));
+        }
+        return true;
+      case '"':
+        _tokenizer.pop(); // remove leading "
+        _state = State::String;
+        return true;
+      case '-':
+      case '0':
+      case '1':
+      case '2':
+      case '3':
+      case '4':
+      case '5':
+      case '6':
+      case '7':
+      case '8':
+      case '9':
+        {
+          _tokenizer.nextWhile(chars::NUMBER_CHARS);
+          if (incomplete()) {
+            return false;
+          }
+          const ValueType type = numberType(_tokenizer.current());
+          if (type == ValueType::Invalid) {
+            _tokenizer.abort(F("Invalid number format."));
+            return true;
+          }
+          _handler.onNumber(Number {_tokenizer.current(), type});
+          _tokenizer.pop();
+          _state = State::AfterValue;
+        }
+        return true;
+      case '[':
+        _tokenizer.pop();
+        if (_tokenizer.enterStructure(true)) {
+          _handler.onOpenList();
+          _state = State::FirstElement;
+        }
+        return true;
+      case '{':
+        _tokenizer.pop();
+        if (_tokenizer.enterStructure(false)) {
+          _handler.onOpenObject();
+          _state = State::FirstProperty;
+        }
+        return true;
+      default:
+        if (exhausted()) {
+          return false;
+        }
+        _tokenizer.abort(F("Unexpected character at start of value."));
+        return true;
+    }
+  }
+
+  /** Reads the contents of a string, returns false if it needs more input. */
+  bool parseString(bool name) {
+    if (_tokenizer.nextUntil(chars::STRING_DELIMITERS, '\\') != '"') {
+      if (incomplete()) {
+        return false;
+      }
+      const size_t length = strlen(_tokenizer.current());
+      if (length < MAX_TOKEN_LENGTH) {
+        _tokenizer.abort(F("Unexpected end of input in string."));
+      } else if (name) {
+        _tokenizer.abort(F("String longer than maximum token length."));
+      } else {
+        parseStringFragment(length);
+      }
+      return true;
+    }
+
+    if (!handleEscapes()) {
+      return true;
+    }
+    if (name) {
+      _handler.onKey(_tokenizer.current());
+      _state = State::Colon;
+    } else {
+      _handler.onString(_tokenizer.current());
+      _state = State::AfterValue;
+    }
+    _tokenizer.pop(); // remove string contents
+    _tokenizer.pop(); // remove trailing "
+    return true;
+  }
+
+  /**
+   * Checks the contents of a string for escape sequences which are not
+   * valid in JSON and for control characters, which must be escaped.
+   * Aborts and returns false if there is one.
+   */
+  bool checkString(const char* string) {
+    for (const char* p = string; *p != '\0'; ++p) {
+      if (static_cast<uint8_t>(*p) < 0x20u) {
+        _tokenizer.abort(F("Unescaped control character in string."));
+        return false;
+      }
+      if (*p != '\\') {
+        continue;
+      }
+      uint16_t unit;
+      switch (p[1]) {
+        case '"':
+        case '\\':
+        case '/':
+        case 'b':
+        case 'f':
+        case 'n':
+        case 'r':
+        case 't':
+          p += 1;
+          break;
+        case 'u':
+          if (!parseHex4(p + 2, unit)) {
+            _tokenizer.abort(F("Invalid escape sequence in string."));
+            return false;
+          }
+          p += 5;
+          break;
+        default:
+          _tokenizer.abort(F("Invalid escape sequence in string."));
+          return false;
+      }
+    }
+    return true;
+  }
+
+  /**
+   * Decodes the escape sequences of the current token, or only checks the
+   * token with RAW_STRINGS (see checkString()). Returns false if it is
+   * invalid.
+   */
+  bool handleEscapes() {
+    if (!RAW_STRINGS) {
+      _tokenizer.handleEscapedChars('\\', &jsonEscapeHandler);
+      return true;
+    }
+    return checkString(_tokenizer.current());
+  }
+
+  /** Reports the current token as fragment of a string which does not fit into the buffer. */
+  void parseStringFragment(size_t length) {
+    const size_t completeLength = completeEscapesLength(_tokenizer.current(), length);
+    if (completeLength == 0) {
+      _tokenizer.abort(F("Escape sequence longer than maximum token length."));
+      return;
+    }
+    _tokenizer.truncate(completeLength);
+    if (!handleEscapes()) {
+      return;
+    }
+    _handler.onStringFragment(_tokenizer.current());
+    _tokenizer.pop();
+  }
+
+  void close() {
+    const bool list = _tokenizer.inList();
+    _tokenizer.pop();
+    _tokenizer.leaveStructure();
+    if (list) {
+      _handler.onCloseList();
+    } else {
+      _handler.onCloseObject();
+    }
+    _state = State::AfterValue;
+  }
+
+  /** Parses the next token, returns false if it needs more input. */
+  bool step() {
+    if (_state != State::String && _state != State::Name) {
+      _tokenizer.skip(); // skip whitespace
+    }
+
+    switch (_state) {
+      case State::FirstElement:
+        if (_tokenizer.peek("]") == ']') {
+          close();
+          return true;
+        }
+        return parseValue();
+      case State::Value:
+        return parseValue();
+      case State::FirstProperty:
+      case State::NextProperty:
+        switch (_tokenizer.peek(_state == State::FirstProperty ? "\"}" : "\"")) {
+          case '"':
+            _tokenizer.pop(); // remove leading "
+            _state = State::Name;
+            return true;
+          case '}':
+            close();
+            return true;
+          default:
+            if (exhausted()) {
+              return false;
+            }
+            _tokenizer.abort(F("Expected '\"' at start of property name."));
+            return true;
+        }
+      case State::String:
+        return parseString(false);
+      case State::Name:
+        return parseString(true);
+      case State::Colon:
+        if (_tokenizer.peek(":") == ':') {
+          _tokenizer.pop();
+          _state = State::Value;
+          return true;
+        }
+        if (exhausted()) {
+          return false;
+        }
+        _tokenizer.abort(F("Expected ':' after property name."));
+        return true;
+      case State::AfterValue:
+        if (_tokenizer.depth() == 0) {
+          _state = State::Done;
+          return true;
+        }
+        switch (_tokenizer.peek(_tokenizer.inList() ? ",]" : ",}")) {
+          case ',':
+            _tokenizer.pop();
+            _state = _tokenizer.inList() ? State::Value : State::NextProperty;
+            return true;
+          case '\0':
+            if (exhausted()) {
+              return false;
+            }
+            if (_tokenizer.inList()) {
+              _tokenizer.abort(F("Unexpected character in list."));
+            } else {
+              _tokenizer.abort(F("Unexpected character in object."));
+            }
+            return true;
+          default:
+            close();
+            return true;
+        }
+      case State::Done:
+        if (*_tokenizer.current() != '\0') {
+          _tokenizer.abort(F("Unexpected characters at end of document."));
+        }
+        return false;
+    }
+    return false;
+  }
+
+public:
+  template<typename... Args>
+  EventParser(Handler& handler, Args&&... args) : _tokenizer(std::forward<Args>(args)...), _handler(handler), _state(State::Value), _finished(false) {}
+
+  /**
+   * Sets whether all of the input is available, i.e. running out of input
+   * is the end of the document.
+   */
+  void finished(bool finished) {
+    _finished = finished;
+  }
+
+  /**
+   * Parses as much of the document as the input allows. Returns Done once
+   * the root value is complete, or NeedMoreData if the input ran out before.
+   */
+  ParseStatus parse() {
+    while (!_tokenizer.aborted() && step()) {}
+
+    if (_tokenizer.aborted()) {
+      return ParseStatus::Failed;
+    }
+    if (_state != State::Done) {
+      return ParseStatus::NeedMoreData;
+    }
+    return ParseStatus::Done;
+  }
+
+  bool failed() const {
+    return _tokenizer.aborted();
+  }
+
+  ReaderDiagnostics diagnostics() const {
+    return {
+      _tokenizer.positionInInput(),
+      _tokenizer.current(),
+      _tokenizer.abortReason(),
+#if defined(JSONS_STATS)
+      _tokenizer.stats(),
+#endif
+    };
+  }
+};
+
+/**
+ * Input of a PushParser, which provides the chunk currently being fed.
+ */
+class ChunkInput {
+  const char* _data = nullptr;
+  size_t _length = 0u;
+
+public:
+  void assign(const char* data, size_t length) {
+    _data = data;
+    _length = length;
+  }
+
+  size_t available() const {
+    return _length;
+  }
+
+  char read() {
+    if (_length == 0u) {
+      return '\0';
+    }
+    --_length;
+    return *_data++;
+  }
+
+  size_t readString(char* buffer, size_t length) {
+    const size_t count = std::min(length, _length);
+    memcpy(buffer, _data, count);
+    _data += count;
+    _length -= count;
+    return count;
+  }
+};
+
+/**
+ * Resumable parser for documents which arrive in chunks (e.g. from the
+ * network), so parsing overlaps with receiving the rest. Each chunk is
+ * parsed as far as possible and the parser then waits for the next one,
+ * with a partial token kept in its buffer. The events are reported to the
+ * handler as with EventParser.
+ *
+ * The chunks can be reused by the caller as soon as feed() returns.
+ */
+template<typename Handler, size_t max_token_length = 64u, size_t max_depth = 32u>
+class PushParser final : private ChunkInput, public EventParser<ChunkInput, Handler, max_token_length, max_depth> {
+  using Parser = EventParser<ChunkInput, Handler, max_token_length, max_depth>;
+
+public:
+  explicit PushParser(Handler& handler) : ChunkInput(), Parser(handler, static_cast<ChunkInput&>(*this)) {}
+
+  PushParser(const PushParser& other) = delete;
+  PushParser& operator=(const PushParser& other) = delete;
+
+  /**
+   * Parses the next chunk of the document. Returns NeedMoreData while the
+   * document is not complete yet.
+   */
+  ParseStatus feed(const char* data, size_t length) {
+    assign(data, length);
+    const ParseStatus status = Parser::parse();
+    assign(nullptr, 0u);
+    return status;
+  }
+
+  /**
+   * Marks the end of the document, i.e. fails if it is not complete (and
+   * parses a number at its very end, which only ends there).
+   */
+  ParseStatus finish() {
+    Parser::finished(true);
+    return Parser::parse();
+  }
+};
+
+/**
+ * Parses a whole document from the input and reports it to the handler,
+ * which is the fastest way to read a document if its structure is not
+ * needed (e.g. for transcoding or validation). As with Reader, the input
+ * ends once it has nothing available anymore.
+ *
+ * Returns the parser to check if it failed() and for its diagnostics().
+ */
+template<size_t max_token_length = 64u, size_t max_depth = 32u, typename Input, typename Handler>
+EventParser<Input, Handler, max_token_length, max_depth> parse(Input& input, Handler& handler) {
+  EventParser<Input, Handler, max_token_length, max_depth> parser {handler, input};
+  parser.finished(true);
+  parser.parse();
+  return parser;
+}
+
+/**
+ * Checks if the document from the input is valid JSON (including its escape
+ * sequences) without producing any values, so it is much faster than reading
+ * it. With the same maximum token length and depth as a Reader, it fails for
+ * the same documents, except for invalid escape sequences (which the reader
+ * keeps as they are) and unescaped control characters in strings (which the
+ * reader accepts).
+ *
+ * Returns the parser to check if it failed() and for its diagnostics().
+ */
+template<size_t max_token_length = 64u, size_t max_depth = 32u, typename Input>
+EventParser<Input, EventHandler, max_token_length, max_depth, true> validate(Input& input) {
+  static EventHandler handler; // has no state, so it can be shared
+  EventParser<Input, EventHandler, max_token_length, max_depth, true> parser {handler, input};
+  parser.finished(true);
+  parser.parse();
+  return parser;
+}
+
+}
+
+}
+
+#endif
@@ -0,0 +1,79 @@
+#ifndef JSONS_KEYTABLE_H_
+#define JSONS_KEYTABLE_H_
+
+#include <cstdint>
+#include <cstring>
+#include <toolbox/String.h>
+
+namespace jsons {
+
+/** Same as strcmp(a, b) < 0, but usable in constant expressions. */
+constexpr bool keyLess(const char* a, const char* b) {
+  return *a != *b ? static_cast<unsigned char>(*a) < static_cast<unsigned char>(*b) : *a != '\0' && keyLess(a + 1, b + 1);
+}
+
+/**
+ * Whether the names are strictly sorted as required by KeyTable, which is
+ * meant to be checked at compile time with static_assert.
+ */
+template<size_t size>
+constexpr bool keysSorted(const char* const (&names)[size], size_t index = 1u) {
+  return index >= size || (keyLess(names[index - 1u], names[index]) && keysSorted(names, index + 1u));
+}
+
+/**
+ * Table of known property names of an object, which allows to dispatch on
+ * properties by a small integer key (the index in the table) instead of
+ * comparing names.
+ *
+ * The names must be sorted (as by strcmp), they are looked up with a binary
+ * search and names of an unsorted table are not found. Tables of constexpr
+ * names should therefore be checked with keysSorted(), e.g.
+ *
+ *   static constexpr const char* NAMES[] = {"id", "interval", "name"};
+ *   static_assert(jsons::keysSorted(NAMES), "NAMES must be sorted");
+ *
+ * The table only references the names, so they must outlive it (usually
+ * they are a static array).
+ */
+class KeyTable final {
+  const char* const* _names;
+  size_t _size;
+
+public:
+  static const size_t UNKNOWN = SIZE_MAX;
+
+  template<size_t size>
+  constexpr KeyTable(const char* const (&names)[size]) : _names(names), _size(size) {}
+
+  size_t size() const { return _size; }
+
+  size_t find(const char* name) const {
+    size_t low = 0;
+    size_t high = _size;
+    while (low < high) {
+      const size_t middle = low + (high - low) / 2;
+      const int comparison = strcmp(name, _names[middle]);
+      if (comparison == 0) {
+        return middle;
+      } else if (comparison < 0) {
+        high = middle;
+      } else {
+        low = middle + 1;
+      }
+    }
+    return UNKNOWN;
+  }
+
+  toolbox::strref name(size_t key) const {
+    if (key < _size) {
+      return _names[key];
+    } else {
+      return {};
+    }
+  }
+};
+
+}
+
+#endif
@@ -2,13 +2,90 @@
 #define JSONS_READER_H_
 
 #include "Tokenizer.h"
+#include "SpanTokenizer.h"
+#include "KeyTable.h"
+#include <cstdlib>
+#include <utility>
 #include <toolbox/String.h>
 #include <toolbox/Maybe.h>
 #include <toolbox/Decimal.h>
 
 namespace jsons {
+inline namespace JSONS_STATS_NAMESPACE {
 
-static size_t jsonEscapeHandler(const char** source, char** destination) {
+static inline bool parseHex4(const char* chars, uint16_t& value) {
+  value = 0;
+  for (size_t i = 0; i < 4; ++i) {
+    const char c = chars[i];
+    value <<= 4;
+    if (c >= '0' && c <= '9') {
+      value |= c - '0';
+    } else if (c >= 'a' && c <= 'f') {
+      value |= c - 'a' + 10;
+    } else if (c >= 'A' && c <= 'F') {
+      value |= c - 'A' + 10;
+    } else {
+      return false; // also stops at the terminating zero
+    }
+  }
+  return true;
+}
+
+static inline bool isHighSurrogate(uint16_t unit) { return unit >= 0xD800 && unit <= 0xDBFF; }
+
+static inline bool isLowSurrogate(uint16_t unit) { return unit >= 0xDC00 && unit <= 0xDFFF; }
+
+static inline size_t encodeUtf8(uint32_t codePoint, char* destination) {
+  if (codePoint < 0x80) {
+    destination[0] = static_cast<char>(codePoint);
+    return 1;
+  } else if (codePoint < 0x800) {
+    destination[0] = static_cast<char>(0xC0 | (codePoint >> 6));
+    destination[1] = static_cast<char>(0x80 | (codePoint & 0x3F));
+    return 2;
+  } else if (codePoint < 0x10000) {
+    destination[0] = static_cast<char>(0xE0 | (codePoint >> 12));
+    destination[1] = static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+    destination[2] = static_cast<char>(0x80 | (codePoint & 0x3F));
+    return 3;
+  } else {
+    destination[0] = static_cast<char>(0xF0 | (codePoint >> 18));
+    destination[1] = static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F));
+    destination[2] = static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+    destination[3] = static_cast<char>(0x80 | (codePoint & 0x3F));
+    return 4;
+  }
+}
+
+/**
+ * Decodes a \uXXXX escape sequence (or a surrogate pair of two of them)
+ * starting at escape into UTF-8. Lone surrogates are replaced by U+FFFD.
+ * 
+ * Returns the length of the escape sequence, or 0 if it is not valid (or
+ * is \u0000, which cannot be represented in the decoded string).
+ */
+static inline size_t decodeUnicodeEscape(const char* escape, uint32_t& codePoint) {
+  uint16_t unit;
+  if (!parseHex4(escape + 2, unit) || unit == 0) {
+    return 0;
+  }
+
+  if (isHighSurrogate(unit)) {
+    uint16_t low;
+    if (escape[6] == '\\' && escape[7] == 'u' && parseHex4(escape + 8, low) && isLowSurrogate(low)) {
+      codePoint = 0x10000 + ((static_cast<uint32_t>(unit) - 0xD800) << 10) + (low - 0xDC00);
+      return 12;
+    }
+    codePoint = 0xFFFD;
+  } else if (isLowSurrogate(unit)) {
+    codePoint = 0xFFFD;
+  } else {
+    codePoint = unit;
+  }
+  return 6;
+}
+
+static inline size_t jsonEscapeHandler(const char** source, char** destination) {
   ++(*source);
   switch (**source) {
     case '"':
@@ -36,7 +113,22 @@ static size_t jsonEscapeHandler(const char** source, char** destination) {
       **destination = '\t';
       return 1;
     case 'u':
-      // TODO implement unicode character handling (\uxxxx)?
+      {
+        // UTF-8 is never longer than the escape sequence, so it can be written in place
+        uint32_t codePoint;
+        const size_t escapeLength = decodeUnicodeEscape(*source - 1, codePoint);
+        if (escapeLength > 0) {
+          const size_t decodedLength = encodeUtf8(codePoint, *destination);
+          *source += escapeLength - 2;
+          *destination += decodedLength - 1;
+          return escapeLength - decodedLength;
+        }
+      }
+      // keep invalid sequences as they are
+      **destination = '\\';
+      ++(*destination);
+      **destination = 'u';
+      return 0;
     default:
       **destination = '\\';
       ++(*destination);
@@ -45,34 +137,473 @@ static size_t jsonEscapeHandler(const char** source, char** destination) {
   }
 }
 
+/**
+ * Decodes the escape sequences of contents which are escaped for JSON into
+ * the buffer, which has room for capacity characters and the terminating
+ * zero. Returns false if the decoded contents do not fit.
+ */
+static inline bool decodeEscapes(const char* contents, char* buffer, size_t capacity) {
+  const char* source = contents;
+  char* destination = buffer;
+  char* const end = buffer + capacity;
+  while (*source != '\0') {
+    if (*source != '\\') {
+      if (destination == end) {
+        return false;
+      }
+      *destination++ = *source++;
+      continue;
+    }
+    if (source[1] == '\0') {
+      return false;
+    }
+    char decoded[4];
+    char* last = decoded;
+    jsonEscapeHandler(&source, &last);
+    const size_t length = static_cast<size_t>(last - decoded) + 1u;
+    if (length > static_cast<size_t>(end - destination)) {
+      return false;
+    }
+    memcpy(destination, decoded, length);
+    destination += length;
+    ++source;
+  }
+  *destination = '\0';
+  return true;
+}
+
+static inline bool isEscapeStart(const char* fragment, size_t index) {
+  size_t precedingEscapeChars = 0;
+  while (index > precedingEscapeChars && fragment[index - 1 - precedingEscapeChars] == '\\') {
+    ++precedingEscapeChars;
+  }
+  return fragment[index] == '\\' && precedingEscapeChars % 2 == 0;
+}
+
+static inline size_t escapeLength(const char* escape, size_t available) {
+  if (available < 2 || escape[1] != 'u') {
+    return 2;
+  }
+  uint16_t unit;
+  if (available >= 6 && parseHex4(escape + 2, unit) && isHighSurrogate(unit)) {
+    return 12; // may be followed by the low surrogate
+  }
+  return 6;
+}
+
+/**
+ * Returns the length of the string fragment without an escape sequence at
+ * its end which is not complete yet (i.e. continues in the next fragment).
+ */
+static inline size_t completeEscapesLength(const char* fragment, size_t length) {
+  // the longest escape sequence is a surrogate pair with 12 characters
+  for (size_t i = length > 12 ? length - 12 : 0; i < length; ++i) {
+    if (isEscapeStart(fragment, i)) {
+      const size_t sequenceLength = escapeLength(fragment + i, length - i);
+      if (i + sequenceLength > length) {
+        // a high surrogate directly before the incomplete escape belongs to it
+        if (i >= 6 && isEscapeStart(fragment, i - 6) && escapeLength(fragment + i - 6, 6) == 12) {
+          return i - 6;
+        }
+        return i;
+      }
+      i += sequenceLength - 1;
+    }
+  }
+  return length;
+}
+
+/**
+ * Skips (the rest of) a list or object with ITokenizer::skipStructure(),
+ * including whitespace after it.
+ */
+template<typename Tokenizer>
+static void skipStructurally(Tokenizer& tokenizer, size_t depth) {
+  if (tokenizer.skipStructure(depth)) {
+    tokenizer.skip(); // skip whitespace
+  } else if (!tokenizer.aborted()) {
+    tokenizer.abort(F("Unexpected end of input."));
+  }
+}
+
+/**
+ * Whether the current token does not fit into the buffer of the tokenizer
+ * only because pinned tokens (see PinningTokenizer) take up part of it.
+ */
+template<typename Tokenizer>
+static bool exhaustedByPins(const Tokenizer& tokenizer) {
+  return !tokenizer.completed() && strlen(tokenizer.current()) < tokenizer.maxTokenLength();
+}
+
 enum struct ValueType { Invalid, Null, Boolean, Integer, Decimal, String, List, Object };
 
-class List;
-class Object;
+static inline const char* skipDigits(const char* p) {
+  while (*p >= '0' && *p <= '9') {
+    ++p;
+  }
+  return p;
+}
+
+/**
+ * Returns the type of a number literal, i.e. Integer if it only has an
+ * integer part and Decimal if it has a fraction and/or an exponent, or
+ * Invalid if it is not a valid number.
+ */
+static inline ValueType numberType(const char* literal) {
+  ValueType type = ValueType::Integer;
+  const char* p = literal;
+  if (*p == '-') {
+    ++p;
+  }
+  const char* digits = p;
+  p = skipDigits(p);
+  if (p == digits || (*digits == '0' && p - digits > 1)) {
+    return ValueType::Invalid; // no digits or a leading zero
+  }
+  if (*p == '.') {
+    digits = ++p;
+    p = skipDigits(p);
+    if (p == digits) {
+      return ValueType::Invalid;
+    }
+    type = ValueType::Decimal;
+  }
+  if (*p == 'e' || *p == 'E') {
+    ++p;
+    if (*p == '+' || *p == '-') {
+      ++p;
+    }
+    digits = p;
+    p = skipDigits(p);
+    if (p == digits) {
+      return ValueType::Invalid;
+    }
+    type = ValueType::Decimal;
+  }
+  return *p == '\0' ? type : ValueType::Invalid;
+}
+
+/**
+ * Parses an integer literal (see numberType()) without going through
+ * Decimal or strtod(), returns false if it does not fit into 64 bits.
+ */
+static inline bool parseInteger(const char* literal, int64_t& value) {
+  const bool negative = *literal == '-';
+  const uint64_t limit = negative ? uint64_t(INT64_MAX) + 1u : uint64_t(INT64_MAX);
+  uint64_t magnitude = 0;
+  for (const char* p = negative ? literal + 1 : literal; *p != '\0'; ++p) {
+    const uint8_t digit = *p - '0';
+    if (magnitude > (limit - digit) / 10u) {
+      return false;
+    }
+    magnitude = magnitude * 10u + digit;
+  }
+  value = negative ? static_cast<int64_t>(0u - magnitude) : static_cast<int64_t>(magnitude);
+  return true;
+}
+
+/**
+ * Parses a non-negative integer literal (see numberType()) into an unsigned
+ * 64-bit integer, returns false if it is negative or does not fit.
+ */
+static inline bool parseUnsigned(const char* literal, uint64_t& value) {
+  if (*literal == '-') {
+    value = 0u;
+    return strcmp(literal, "-0") == 0;
+  }
+  uint64_t magnitude = 0;
+  for (const char* p = literal; *p != '\0'; ++p) {
+    const uint8_t digit = *p - '0';
+    if (magnitude > (UINT64_MAX - digit) / 10u) {
+      return false;
+    }
+    magnitude = magnitude * 10u + digit;
+  }
+  value = magnitude;
+  return true;
+}
+
+/**
+ * A number literal (see numberType()) with its conversions, which return
+ * nothing if the literal is not a number or does not fit into the type.
+ */
+class Number final {
+  const char* _literal;
+  ValueType _type;
+
+public:
+  Number() : _literal(""), _type(ValueType::Invalid) {}
+  Number(const char* literal, ValueType type) : _literal(literal), _type(type) {}
+
+  bool valid() const { return _type == ValueType::Integer || _type == ValueType::Decimal; }
+  ValueType type() const { return _type; }
+  const char* literal() const { return _literal; }
+
+  toolbox::Maybe<int32_t> asInteger() const {
+    auto value = asInteger64();
+    if (!value || value.get() < INT32_MIN || value.get() > INT32_MAX) {
+      return {};
+    }
+    return {static_cast<int32_t>(value.get())};
+  }
+
+  /**
+   * Returns the number as 64-bit integer, which is exact for integers (e.g.
+   * timestamps in milliseconds). Decimals are truncated towards zero.
+   */
+  toolbox::Maybe<int64_t> asInteger64() const {
+    if (_type == ValueType::Integer) {
+      int64_t value;
+      if (parseInteger(_literal, value)) {
+        return {value};
+      }
+    } else if (_type == ValueType::Decimal) {
+      // the bounds are exactly representable, INT64_MAX itself is not
+      const double value = strtod(_literal, nullptr);
+      if (value >= -9223372036854775808.0 && value < 9223372036854775808.0) {
+        return {static_cast<int64_t>(value)};
+      }
+    }
+    return {};
+  }
+
+  /**
+   * Returns the number as unsigned 64-bit integer, which covers the values
+   * beyond INT64_MAX as well. Only integers are converted.
+   */
+  toolbox::Maybe<uint64_t> asUnsigned64() const {
+    uint64_t value;
+    if (_type == ValueType::Integer && parseUnsigned(_literal, value)) {
+      return {value};
+    }
+    return {};
+  }
+
+  /**
+   * Returns the number as double, which also covers numbers with an exponent
+   * (which cannot be represented as Decimal) at the cost of precision.
+   */
+  toolbox::Maybe<double> asDouble() const {
+    if (!valid()) {
+      return {};
+    }
+    return {strtod(_literal, nullptr)};
+  }
+
+  /**
+   * Returns the number as Decimal. Numbers with an exponent are only
+   * supported as far as Decimal::fromString() supports them, asDouble()
+   * reads any number.
+   */
+  toolbox::Maybe<toolbox::Decimal> asDecimal() const {
+    if (!valid()) {
+      return {};
+    }
+    return toolbox::Decimal::fromString(_literal);
+  }
+};
+
+/**
+ * Range over the contents of a string value in fragments of at most the
+ * maximum token length, which allows to process strings of any length (e.g.
+ * by writing them to some other output as they are read).
+ * 
+ * Escape sequences are never split between fragments, so each fragment is
+ * already fully decoded. Each fragment is only valid until the iterator is
+ * advanced.
+ */
+template<typename Tokenizer>
+class BasicStringFragments final {
+public:
+  class Iterator;
+  struct EndIterator final {
+    bool operator!=(const Iterator& it) const {
+      return it != *this;
+    }
+  };
+
+  class Iterator final {
+    Tokenizer* _tokenizer;
+    toolbox::strref _current;
+    bool _valid;
+    bool _last;
+
+    void read() {
+      if (_tokenizer->nextUntil(chars::STRING_DELIMITERS, '\\') == '"') {
+        if (*_tokenizer->current() == '\0') {
+          // the previous fragment ended right before the trailing ", so there is no fragment left
+          _tokenizer->pop(); // remove (empty) fragment
+          _tokenizer->pop(); // remove trailing "
+          _tokenizer->skip(); // skip whitespace
+          _valid = false;
+          return;
+        }
+        _last = true;
+      } else if (_tokenizer->completed() || _tokenizer->aborted()) {
+        _tokenizer->abort(F("Unexpected end of input in string."));
+        _valid = false;
+        return;
+      } else {
+        const char* fragment = _tokenizer->current();
+        const size_t length = strlen(fragment);
+        const size_t completeLength = completeEscapesLength(fragment, length);
+        if (completeLength == 0) {
+          _tokenizer->abort(F("Escape sequence longer than maximum token length."));
+          _valid = false;
+          return;
+        }
+        _tokenizer->truncate(completeLength);
+        _last = false;
+      }
+      _tokenizer->handleEscapedChars('\\', &jsonEscapeHandler);
+      _current = _tokenizer->current();
+      _valid = true;
+    }
+
+    void advance() {
+      if (!_valid) {
+        return;
+      }
+
+      if (_tokenizer == nullptr) {
+        _valid = false;
+        return;
+      }
+
+      _tokenizer->pop(); // remove fragment
+      if (_last) {
+        _tokenizer->pop(); // remove trailing "
+        _tokenizer->skip(); // skip whitespace
+        _valid = false;
+      } else {
+        read();
+      }
+    }
+
+  public:
+    Iterator() : _tokenizer(nullptr), _current(), _valid(false), _last(true) {}
+    Iterator(const toolbox::strref& string) : _tokenizer(nullptr), _current(string), _valid(true), _last(true) {}
+    Iterator(Tokenizer& tokenizer) : _tokenizer(&tokenizer), _current(), _valid(false), _last(false) {
+      read();
+    }
+    Iterator(Iterator&& other) : Iterator() {
+      std::swap(_tokenizer, other._tokenizer);
+      std::swap(_current, other._current);
+      std::swap(_valid, other._valid);
+      std::swap(_last, other._last);
+    }
+    Iterator& operator=(Iterator&& other) {
+      if (this != &other) {
+        std::swap(_tokenizer, other._tokenizer);
+        std::swap(_current, other._current);
+        std::swap(_valid, other._valid);
+        std::swap(_last, other._last);
+      }
+      return *this;
+    }
+    ~Iterator() {
+      while (_valid) {
+        advance();
+      }
+    }
+
+    Iterator(const Iterator& other) = delete;
+    Iterator& operator=(const Iterator& other) = delete;
+
+    const toolbox::strref& operator*() const {
+      return _current;
+    }
+
+    Iterator& operator++() {
+      advance();
+      return *this;
+    }
+
+    bool operator!=(const EndIterator&) const {
+      return _valid;
+    }
+  };
+
+private:
+  Tokenizer* _tokenizer;
+  toolbox::strref _string;
+  bool _consumed;
 
-class Value {
 public:
-  using Tokenizer = IStoringTokenizer;
+  BasicStringFragments() : _tokenizer(nullptr), _string(), _consumed(true) {}
+  BasicStringFragments(const toolbox::strref& string) : _tokenizer(nullptr), _string(string), _consumed(false) {}
+  BasicStringFragments(Tokenizer& tokenizer) : _tokenizer(&tokenizer), _string(), _consumed(false) {}
+  BasicStringFragments(BasicStringFragments&& other) : BasicStringFragments() {
+    std::swap(_tokenizer, other._tokenizer);
+    std::swap(_string, other._string);
+    std::swap(_consumed, other._consumed);
+  }
+  BasicStringFragments& operator=(BasicStringFragments&& other) {
+    if (this != &other) {
+      std::swap(_tokenizer, other._tokenizer);
+      std::swap(_string, other._string);
+      std::swap(_consumed, other._consumed);
+    }
+    return *this;
+  }
+  ~BasicStringFragments() {
+    if (!_consumed && _tokenizer) {
+      Iterator remaining {*_tokenizer}; // skips all fragments when destroyed
+    }
+  }
+
+  BasicStringFragments(const BasicStringFragments& other) = delete;
+  BasicStringFragments& operator=(const BasicStringFragments& other) = delete;
+
+  Iterator begin() {
+    if (_consumed) {
+      return {};
+    }
+    _consumed = true;
+    if (_tokenizer) {
+      return {*_tokenizer};
+    } else {
+      return {_string};
+    }
+  }
+
+  EndIterator end() const {
+    return {};
+  }
+};
+
+template<typename Tokenizer>
+class BasicList;
+template<typename Tokenizer>
+class BasicObject;
 
+/**
+ * A JSON value read with a tokenizer. The Tokenizer type usually is the
+ * IStoringTokenizer interface (see the Value alias below), but can also be a
+ * concrete tokenizer type to avoid virtual calls (see Reader::beginInline()).
+ */
+template<typename Tokenizer>
+class BasicValue {
 protected:
   Tokenizer* _tokenizer;
   ValueType _type;
   bool _consumed;
   struct {
     bool boolean;
-    toolbox::Decimal decimal;
+    bool longString;
+    bool exhaustedByPins;
   } _primitives;
 
 public:
-  Value() : _tokenizer(nullptr), _type(ValueType::Invalid), _consumed(false), _primitives() {}
-  Value(Tokenizer& tokenizer) : _tokenizer(&tokenizer), _type(ValueType::Invalid), _consumed(false), _primitives() {}
-  Value(Value&& other) : Value() {
+  BasicValue() : _tokenizer(nullptr), _type(ValueType::Invalid), _consumed(false), _primitives() {}
+  BasicValue(Tokenizer& tokenizer) : _tokenizer(&tokenizer), _type(ValueType::Invalid), _consumed(false), _primitives() {}
+  BasicValue(BasicValue&& other) : BasicValue() {
     std::swap(_tokenizer, other._tokenizer);
     std::swap(_type, other._type);
     std::swap(_consumed, other._consumed);
     std::swap(_primitives, other._primitives);
   }
-  Value& operator=(Value&& other) {
+  BasicValue& operator=(BasicValue&& other) {
     if (this != &other) {
       std::swap(_tokenizer, other._tokenizer);
       std::swap(_type, other._type);
@@ -81,25 +612,27 @@ public:
     }
     return *this;
   }
-  ~Value() {
+  ~BasicValue() {
     skip();
   }
 
-  Value(const Value& other) = delete;
-  Value& operator=(const Value& other) = delete;
+  BasicValue(const BasicValue& other) = delete;
+  BasicValue& operator=(const BasicValue& other) = delete;
 
-  void invalidate() { _type = ValueType::Invalid; }
+  void invalidate() { _type = ValueType::Invalid; _primitives.longString = false; _primitives.exhaustedByPins = false; }
   bool valid() const { return _type != ValueType::Invalid; }
   ValueType type() const { return _type; }
+  bool isLongString() const { return _type == ValueType::String && _primitives.longString; }
 
   void parse() {
     skip();
     invalidate();
     if (_tokenizer) {
+      _tokenizer->releaseToken(0); // the previous value is done
       _tokenizer->skip(); // skip whitespace
       switch (_tokenizer->peek("ntf\"-0123456789[{")) {
         case 'n':
-          _tokenizer->nextUntil(" \r\n\t,]}");
+          _tokenizer->nextUntil(chars::VALUE_DELIMITERS);
           if (strcmp(_tokenizer->current(), "null") == 0) {
             _tokenizer->pop();
             _type = ValueType::Null;
@@ -109,7 +642,7 @@ public:
           }
           break;
         case 't':
-          _tokenizer->nextUntil(" \r\n\t,]}");
+          _tokenizer->nextUntil(chars::VALUE_DELIMITERS);
           if (strcmp(_tokenizer->current(), "true") == 0) {
             _primitives.boolean = true;
             _tokenizer->pop();
@@ -120,7 +653,7 @@ public:
           }
           break;
         case 'f':
-          _tokenizer->nextUntil(" \r\n\t,]}");
+          _tokenizer->nextUntil(chars::VALUE_DELIMITERS);
           if (strcmp(_tokenizer->current(), "false") == 0) {
             _primitives.boolean = false;
             _tokenizer->pop();
@@ -132,19 +665,21 @@ public:
           break;
         case '"':
           _tokenizer->pop(); // remove leading "
-          if (_tokenizer->nextUntil("\"", '\\') == '"') {
+          if (_tokenizer->nextUntil(chars::STRING_DELIMITERS, '\\') == '"') {
             _tokenizer->handleEscapedChars('\\', &jsonEscapeHandler);
             _tokenizer->storeToken(0);
             _tokenizer->pop(); // remove string contents
             _tokenizer->pop(); // remove trailing "
             _type = ValueType::String;
+          } else if (!_tokenizer->completed()) {
+            // string does not fit into the buffer, leave it there to be read in fragments
+            _primitives.exhaustedByPins = exhaustedByPins(*_tokenizer);
+            _tokenizer->truncate(0);
+            _primitives.longString = true;
+            _type = ValueType::String;
           } else {
-            // TODO implement "long string" handling?
-            // This can be handled similar to a list where the string fragments can be iterated over.
-            // and the caller has to decide how to process it (concatenate into one big string or write it somewhere else).
-            // Note: escape characters may be split accross fragments, so this must be carried over.
             invalidate();
-            _tokenizer->abort(F("String longer than maximum token length."));
+            _tokenizer->abort(F("Unexpected end of input in string."));
           }
           break;
         case '-':
@@ -158,20 +693,13 @@ public:
         case '7':
         case '8':
         case '9':
-          {
-            _tokenizer->nextWhile("-0123456789.");
-            auto decimal = toolbox::Decimal::fromString(_tokenizer->current());
-            if (decimal) {
-              _primitives.decimal = decimal.get();
-              if (_primitives.decimal.isInteger()) {
-                _type = ValueType::Integer;
-              } else {
-                _type = ValueType::Decimal;
-              }
-            } else {
-              invalidate();
-              _tokenizer->abort(F("Invalid number format."));
-            }
+          // only the format is checked here, the literal is kept and converted when read
+          _tokenizer->nextWhile(chars::NUMBER_CHARS);
+          _type = numberType(_tokenizer->current());
+          if (valid()) {
+            _tokenizer->storeToken(0);
+          } else {
+            _tokenizer->abort(F("Invalid number format."));
           }
           break;
         case '[':
@@ -186,7 +714,7 @@ public:
           break;
       }
 
-      if (valid()) {
+      if (valid() && !isLongString()) {
         // skip whitespace in advance to make final value consume the input fully
         _tokenizer->skip();
       }
@@ -195,18 +723,37 @@ public:
     }
   }
 
-  toolbox::Maybe<int32_t> asInteger() const {
+  /** The number, which is not valid() if this is not a number. */
+  Number asNumber() const {
     if (_type != ValueType::Integer && _type != ValueType::Decimal) {
       return {};
     }
-    return {_primitives.decimal.integer()};
+    return {_tokenizer->storedToken(0).cstr(), _type};
+  }
+
+  /** See Number::asInteger(), aborts if the number is out of range. */
+  toolbox::Maybe<int32_t> asInteger() const {
+    return checkRange(asNumber().asInteger());
+  }
+
+  /** See Number::asInteger64(), aborts if the number is out of range. */
+  toolbox::Maybe<int64_t> asInteger64() const {
+    return checkRange(asNumber().asInteger64());
+  }
+
+  /** See Number::asUnsigned64(), aborts if the number is out of range. */
+  toolbox::Maybe<uint64_t> asUnsigned64() const {
+    return checkRange(asNumber().asUnsigned64());
+  }
+
+  /** See Number::asDouble(). */
+  toolbox::Maybe<double> asDouble() const {
+    return asNumber().asDouble();
   }
 
+  /** See Number::asDecimal(), aborts if the number is out of range. */
   toolbox::Maybe<toolbox::Decimal> asDecimal() const {
-    if (_type != ValueType::Integer && _type != ValueType::Decimal) {
-      return {};
-    }
-    return {_primitives.decimal};
+    return checkRange(asNumber().asDecimal());
   }
 
   toolbox::Maybe<bool> asBoolean() const {
@@ -220,18 +767,58 @@ public:
     if (_type != ValueType::String) {
       return {};
     }
+    if (_primitives.longString) {
+      // can only be read with asStringFragments()
+      if (_primitives.exhaustedByPins) {
+        _tokenizer->abort(F("Pinned tokens exhaust the buffer."));
+      } else {
+        _tokenizer->abort(F("String longer than maximum token length."));
+      }
+      return {};
+    }
     return {_tokenizer->storedToken(0)};
   }
 
-  List asList();
+  BasicStringFragments<Tokenizer> asStringFragments();
+
+  BasicList<Tokenizer> asList();
   
-  Object asObject();
+  BasicObject<Tokenizer> asObject();
+
+  BasicObject<Tokenizer> asObject(const KeyTable& keys);
 
   void skip();
+
+  /** Aborts reading, e.g. if the value is not what the application expects. */
+  void abort(const toolbox::strref& reason) const {
+    if (_tokenizer) {
+      _tokenizer->abort(reason);
+    }
+  }
+
+protected:
+  void skipValidated();
+
+  /** Aborts if a number has no value in the requested type. */
+  template<typename T>
+  toolbox::Maybe<T> checkRange(toolbox::Maybe<T>&& value) const {
+    if (!value && (_type == ValueType::Integer || _type == ValueType::Decimal)) {
+      _tokenizer->abort(F("Number out of range."));
+    }
+    return std::move(value);
+  }
 };
 
-class List final : public Value {
+template<typename Tokenizer>
+class BasicList final : public BasicValue<Tokenizer> {
+  using BasicValue<Tokenizer>::_tokenizer;
+  using BasicValue<Tokenizer>::_type;
+  using BasicValue<Tokenizer>::_consumed;
+
 public:
+  using BasicValue<Tokenizer>::valid;
+  using BasicValue<Tokenizer>::invalidate;
+
   class Iterator;
   struct EndIterator final {
     bool operator!=(const Iterator& it) const {
@@ -241,7 +828,7 @@ public:
 
   class Iterator final {
     Tokenizer* _tokenizer;
-    Value _current;
+    BasicValue<Tokenizer> _current;
 
     void advance() {
       if (_current.valid()) {
@@ -254,6 +841,7 @@ public:
             break;
           case ']':
             _tokenizer->pop();
+            _tokenizer->leaveStructure();
             _tokenizer->skip(); // skip whitespace
             _current.invalidate();
             break;
@@ -271,6 +859,7 @@ public:
       _tokenizer->skip(); // skip whitespace
       if (_tokenizer->peek("]") == ']') {
         _tokenizer->pop();
+        _tokenizer->leaveStructure();
         _tokenizer->skip(); // skip whitespace
         _current.invalidate();
       } else {
@@ -289,6 +878,12 @@ public:
       return *this;
     }
     ~Iterator() {
+      if (_current.valid() && !_tokenizer->validateSkipped()) {
+        _current.skip();
+        skipStructurally(*_tokenizer, 1);
+        _tokenizer->leaveStructure();
+        _current.invalidate();
+      }
       while (_current.valid()) {
         advance();
       }
@@ -297,7 +892,7 @@ public:
     Iterator(const Iterator& other) = delete;
     Iterator& operator=(const Iterator& other) = delete;
 
-    Value& operator*() {
+    BasicValue<Tokenizer>& operator*() {
       return _current;
     }
 
@@ -311,7 +906,23 @@ public:
     }
   };
 
-  using Value::Value;
+  using BasicValue<Tokenizer>::BasicValue;
+  BasicList(BasicList&& other) = default;
+  BasicList& operator=(BasicList&& other) = default;
+  ~BasicList() {
+    skip();
+  }
+
+  /**
+   * Skips the rest of the list, which is already opened by parse() (so
+   * BasicValue::skip() would not find its beginning anymore).
+   */
+  void skip() {
+    if (!_consumed && valid()) {
+      begin(); // the iterator skips the rest when it is destroyed
+    }
+    _consumed = true;
+  }
   
   void parse() {
     skip();
@@ -320,7 +931,9 @@ public:
       _tokenizer->skip(); // skip whitespace
       if (_tokenizer->peek("[") == '[') {
         _tokenizer->pop();
-        _type = ValueType::List;
+        if (_tokenizer->enterStructure(true)) {
+          _type = ValueType::List;
+        }
       } else {
         _tokenizer->abort(F("Expected '[' at begin of list."));
         invalidate();
@@ -342,30 +955,50 @@ public:
   }
 };
 
-class Property final : public Value {
+template<typename Tokenizer>
+class BasicProperty final : public BasicValue<Tokenizer> {
+  using BasicValue<Tokenizer>::_tokenizer;
+  using BasicValue<Tokenizer>::_consumed;
+
+  const KeyTable* _keys = nullptr;
+  size_t _key = KeyTable::UNKNOWN;
+
 public:
-  using Value::Value;
+  using BasicValue<Tokenizer>::BasicValue;
+  BasicProperty(Tokenizer& tokenizer, const KeyTable* keys) : BasicValue<Tokenizer>(tokenizer), _keys(keys) {}
+  using BasicValue<Tokenizer>::valid;
+  using BasicValue<Tokenizer>::invalidate;
+  using BasicValue<Tokenizer>::skip;
   
   void parse() {
     skip();
     invalidate();
     if (_tokenizer) {
+      _tokenizer->releaseToken(0); // the value of the previous property is done
       _tokenizer->skip(); // skip whitespace
       if (_tokenizer->peek("\"") == '\"') {
         _tokenizer->pop(); // remove leading "
-        if (_tokenizer->nextUntil("\"", '\\') == '"') {
+        if (_tokenizer->nextUntil(chars::STRING_DELIMITERS, '\\') == '"') {
           _tokenizer->handleEscapedChars('\\', &jsonEscapeHandler);
-          _tokenizer->storeToken(1);
+          if (_keys) {
+            // the name does not need to be stored, as it is in the key table
+            _key = _keys->find(_tokenizer->current());
+          } else {
+            _tokenizer->storeToken(1);
+          }
           _tokenizer->pop(); // remove string contents
           _tokenizer->pop(); // remove trailing "
           _tokenizer->skip(); // skip whitespace
           if (_tokenizer->peek(":") == ':') {
             _tokenizer->pop(); // remove :
-            Value::parse();
+            BasicValue<Tokenizer>::parse();
           } else {
             _tokenizer->abort(F("Expected ':' after property name."));
             invalidate();
           }
+        } else if (exhaustedByPins(*_tokenizer)) {
+          _tokenizer->abort(F("Pinned tokens exhaust the buffer."));
+          invalidate();
         } else {
           _tokenizer->abort(F("String longer than maximum token length."));
           invalidate();
@@ -378,11 +1011,27 @@ public:
     _consumed = false;
   }
   
-  toolbox::strref name() const { return _tokenizer->storedToken(1); }
+  toolbox::strref name() const { return _keys ? _keys->name(_key) : _tokenizer->storedToken(1); }
+
+  /**
+   * The index of the name in the key table of the object, or
+   * KeyTable::UNKNOWN if there is none.
+   */
+  size_t key() const { return _key; }
 };
 
-class Object final : public Value {
+template<typename Tokenizer>
+class BasicObject final : public BasicValue<Tokenizer> {
+  using BasicValue<Tokenizer>::_tokenizer;
+  using BasicValue<Tokenizer>::_type;
+  using BasicValue<Tokenizer>::_consumed;
+
+  const KeyTable* _keys = nullptr;
+
 public:
+  using BasicValue<Tokenizer>::valid;
+  using BasicValue<Tokenizer>::invalidate;
+
   class Iterator;
   class EndIterator final {
   public:
@@ -393,7 +1042,8 @@ public:
 
   class Iterator final {
     Tokenizer* _tokenizer;
-    Property _current;
+    const KeyTable* _keys;
+    BasicProperty<Tokenizer> _current;
 
     void advance() {
       if (_current.valid()) {
@@ -406,6 +1056,7 @@ public:
             break;
           case '}':
             _tokenizer->pop();
+            _tokenizer->leaveStructure();
             _tokenizer->skip(); // skip whitespace
             _current.invalidate();
             break;
@@ -417,30 +1068,46 @@ public:
       }
     }
 
+    void skipUnknownProperties() {
+      while (_keys && _current.valid() && _current.key() == KeyTable::UNKNOWN) {
+        advance();
+      }
+    }
+
   public:
-    Iterator() : _tokenizer(nullptr), _current() {}
-    Iterator(Tokenizer& tokenizer) : _tokenizer(&tokenizer), _current(tokenizer) {
+    Iterator() : _tokenizer(nullptr), _keys(nullptr), _current() {}
+    Iterator(Tokenizer& tokenizer, const KeyTable* keys = nullptr) : _tokenizer(&tokenizer), _keys(keys), _current(tokenizer, keys) {
       _tokenizer->skip(); // skip whitespace
       if (_tokenizer->peek("}") == '}') {
         _tokenizer->pop();
+        _tokenizer->leaveStructure();
         _tokenizer->skip(); // skip whitespace
         _current.invalidate();
       } else {
         _current.parse();
+        skipUnknownProperties();
       }
     }
     Iterator(Iterator&& other) : Iterator() {
       std::swap(_tokenizer, other._tokenizer);
+      std::swap(_keys, other._keys);
       std::swap(_current, other._current);
     }
     Iterator& operator=(Iterator&& other) {
       if (this != &other) {
         std::swap(_tokenizer, other._tokenizer);
+        std::swap(_keys, other._keys);
         std::swap(_current, other._current);
       }
       return *this;
     }
     ~Iterator() {
+      if (_current.valid() && !_tokenizer->validateSkipped()) {
+        _current.skip();
+        skipStructurally(*_tokenizer, 1);
+        _tokenizer->leaveStructure();
+        _current.invalidate();
+      }
       while (_current.valid()) {
         advance();
       }
@@ -449,12 +1116,13 @@ public:
     Iterator(const Iterator& other) = delete;
     Iterator& operator=(const Iterator& other) = delete;
 
-    Property& operator*() {
+    BasicProperty<Tokenizer>& operator*() {
       return _current;
     }
 
     Iterator& operator++() {
       advance();
+      skipUnknownProperties();
       return *this;
     }
     
@@ -463,7 +1131,23 @@ public:
     }
   };
 
-  using Value::Value;
+  using BasicValue<Tokenizer>::BasicValue;
+  BasicObject(BasicObject&& other) = default;
+  BasicObject& operator=(BasicObject&& other) = default;
+  ~BasicObject() {
+    skip();
+  }
+
+  /**
+   * Skips the rest of the object, which is already opened by parse() (so
+   * BasicValue::skip() would not find its beginning anymore).
+   */
+  void skip() {
+    if (!_consumed && valid()) {
+      begin(); // the iterator skips the rest when it is destroyed
+    }
+    _consumed = true;
+  }
   
   void parse() {
     skip();
@@ -472,7 +1156,9 @@ public:
       _tokenizer->skip(); // skip any whitespace
       if (_tokenizer->peek("{") == '{') {
         _tokenizer->pop();
-        _type = ValueType::Object;
+        if (_tokenizer->enterStructure(false)) {
+          _type = ValueType::Object;
+        }
       } else {
         _tokenizer->abort(F("Expected '{' at begin of object."));
         invalidate();
@@ -481,12 +1167,21 @@ public:
     _consumed = false;
   }
 
+  /**
+   * Uses the given table of known property names for iterating the object.
+   * Properties then report their key() and properties with a name which is
+   * not in the table are skipped without storing their names.
+   */
+  void useKeys(const KeyTable& keys) {
+    _keys = &keys;
+  }
+
   Iterator begin() {
     if (_consumed || !valid()) {
       return {};
     }
     _consumed = true;
-    return {*_tokenizer};
+    return {*_tokenizer, _keys};
   }
 
   EndIterator end() const {
@@ -494,38 +1189,66 @@ public:
   }
 };
 
-Object Value::asObject() {
+template<typename Tokenizer>
+BasicObject<Tokenizer> BasicValue<Tokenizer>::asObject() {
   if (_consumed || _type != ValueType::Object) {
     return {};
   }
-  Object object {*_tokenizer};
+  BasicObject<Tokenizer> object {*_tokenizer};
   object.parse();
   _consumed = true;
-  return std::move(object);
+  return object;
 }
 
-List Value::asList() {
+template<typename Tokenizer>
+BasicObject<Tokenizer> BasicValue<Tokenizer>::asObject(const KeyTable& keys) {
+  BasicObject<Tokenizer> object = asObject();
+  object.useKeys(keys);
+  return object;
+}
+
+template<typename Tokenizer>
+BasicStringFragments<Tokenizer> BasicValue<Tokenizer>::asStringFragments() {
+  if (_type != ValueType::String) {
+    return {};
+  }
+  if (!_primitives.longString) {
+    return {_tokenizer->storedToken(0)};
+  }
+  if (_consumed) {
+    return {};
+  }
+  _consumed = true;
+  return {*_tokenizer};
+}
+
+template<typename Tokenizer>
+BasicList<Tokenizer> BasicValue<Tokenizer>::asList() {
   if (_consumed || _type != ValueType::List) {
     return {};
   }
-  List list {*_tokenizer};
+  BasicList<Tokenizer> list {*_tokenizer};
   list.parse();
   _consumed = true;
-  return std::move(list);
+  return list;
 }
 
-void Value::skip() {
+template<typename Tokenizer>
+void BasicValue<Tokenizer>::skip() {
   if (_consumed) { return; }
 
   switch (_type) {
     case ValueType::List:
-      for (auto& e : asList()) {
-        e.skip();
+    case ValueType::Object:
+      if (_tokenizer->validateSkipped()) {
+        skipValidated();
+      } else {
+        skipStructurally(*_tokenizer, 0);
       }
       break;
-    case ValueType::Object:
-      for (auto& p : asObject()) {
-        p.skip();
+    case ValueType::String:
+      if (_primitives.longString) {
+        asStringFragments();
       }
       break;
     default:
@@ -536,43 +1259,173 @@ void Value::skip() {
   _consumed = true;
 }
 
+/**
+ * Skips a list or object (at its opening bracket) by fully parsing it. The
+ * nesting is tracked by the structures of the tokenizer instead of nested
+ * lists and objects, so the stack usage does not depend on the depth.
+ */
+template<typename Tokenizer>
+void BasicValue<Tokenizer>::skipValidated() {
+  const size_t depth = _tokenizer->depth();
+  BasicValue<Tokenizer> element {*_tokenizer};
+  BasicProperty<Tokenizer> property {*_tokenizer};
+  BasicValue<Tokenizer>* current = this;
+
+  while (true) {
+    if (current->_type == ValueType::List || current->_type == ValueType::Object) {
+      const bool list = current->_type == ValueType::List;
+      current->_consumed = true;
+      _tokenizer->pop(); // remove [ or {
+      if (!_tokenizer->enterStructure(list)) {
+        return;
+      }
+      _tokenizer->skip(); // skip whitespace
+      if (_tokenizer->peek(list ? "]" : "}") == '\0') {
+        if (list) {
+          element.parse();
+          current = &element;
+        } else {
+          property.parse();
+          current = &property;
+        }
+        if (!current->valid()) {
+          return;
+        }
+        continue;
+      }
+    } else {
+      current->skip();
+    }
+
+    // the current value is complete, continue with the next one or close the structures
+    while (true) {
+      _tokenizer->skip(); // skip whitespace
+      const bool list = _tokenizer->inList();
+      const char next = _tokenizer->peek(list ? ",]" : ",}");
+      if (next == ',') {
+        _tokenizer->pop();
+        if (list) {
+          element.parse();
+          current = &element;
+        } else {
+          property.parse();
+          current = &property;
+        }
+        if (!current->valid()) {
+          return;
+        }
+        break;
+      } else if (next != '\0') {
+        _tokenizer->pop();
+        _tokenizer->leaveStructure();
+        _tokenizer->skip(); // skip whitespace
+        if (_tokenizer->depth() == depth) {
+          return;
+        }
+      } else {
+        if (list) {
+          _tokenizer->abort(F("Unexpected character in list."));
+        } else {
+          _tokenizer->abort(F("Unexpected character in object."));
+        }
+        return;
+      }
+    }
+  }
+}
+
+using Value = BasicValue<IStoringTokenizer>;
+using List = BasicList<IStoringTokenizer>;
+using Property = BasicProperty<IStoringTokenizer>;
+using Object = BasicObject<IStoringTokenizer>;
+using StringFragments = BasicStringFragments<IStoringTokenizer>;
+
 struct ReaderDiagnostics {
   size_t streamPosition;
   toolbox::strref bufferContents;
   toolbox::strref errorMessage;
+#if defined(JSONS_STATS)
+  ReaderStats stats;
+#endif
 };
 
 class IReader {
 public:
   virtual Value begin() = 0;
   virtual const IReader& end() = 0;
+  virtual bool nextDocument() = 0;
   virtual bool failed() const = 0;
   virtual ReaderDiagnostics diagnostics() const = 0;
 };
 
-template<typename Input, size_t max_token_length>
-class Reader final : public IReader {
-  using Tokenizer = StoringTokenizer<Input, max_token_length, 2u>;
+/**
+ * Reader for JSON documents with a storing tokenizer of the given type,
+ * which is constructed from the arguments of the constructor (see the
+ * Reader and SpanReader aliases below).
+ */
+template<typename tokenizer_type>
+class BasicReader final : public IReader {
+public:
+  using Tokenizer = tokenizer_type;
+  using InlineValue = BasicValue<Tokenizer>;
 
+private:
   Tokenizer _tokenizer;
 
 public:
-  Reader(Input& input) : _tokenizer(input) {}
+  template<typename... Args>
+  explicit BasicReader(Args&&... args) : _tokenizer(std::forward<Args>(args)...) {}
 
   Value begin() override {
     Value root {_tokenizer};
     root.parse();
-    return std::move(root);
+    return root;
+  }
+
+  /**
+   * Same as begin(), but the returned value (and all values within it) use
+   * the concrete tokenizer of this reader instead of the IStoringTokenizer
+   * interface. This allows the compiler to inline the whole parsing, at the
+   * cost of code size for each reader type it is used with.
+   */
+  InlineValue beginInline() {
+    InlineValue root {_tokenizer};
+    root.parse();
+    return root;
   }
 
   const IReader& end() override {
     _tokenizer.skip();
-    if (!_tokenizer.completed()) {
+    if (*_tokenizer.current() != '\0' || !_tokenizer.completed()) {
       _tokenizer.abort("Unexpected characters at end of document.");
     }
     return *this;
   }
 
+  /**
+   * Moves on to the next of several documents in the input, e.g. for
+   * newline-delimited JSON or concatenated messages, which is then read
+   * with begin(). Returns false if there is no further document (or reading
+   * failed). This can also be called before the first document.
+   *
+   * The tokenizer and its buffer are kept, so the input read ahead of the
+   * previous document is not lost. The root value of that document must be
+   * destroyed before.
+   */
+  bool nextDocument() override {
+    _tokenizer.skip();
+    return !_tokenizer.aborted() && *_tokenizer.current() != '\0';
+  }
+
+  /**
+   * Enables full parsing (and thereby validation) of skipped lists and
+   * objects. By default, they are only skipped structurally, which is much
+   * faster but does not detect syntax errors within them.
+   */
+  void validateSkipped(bool enabled) {
+    _tokenizer.validateSkipped(enabled);
+  }
+
   bool failed() const override {
     return _tokenizer.aborted();
   }
@@ -581,14 +1434,57 @@ public:
     return {
       _tokenizer.positionInInput(),
       _tokenizer.current(),
-      _tokenizer.abortReason()
+      _tokenizer.abortReason(),
+#if defined(JSONS_STATS)
+      _tokenizer.stats(),
+#endif
     };
   };
 };
 
-template<typename Input, size_t max_token_length = 64u>
-Reader<Input, max_token_length> makeReader(Input& input) {
-  return Reader<Input, max_token_length>(input);
+/**
+ * Reader for JSON documents from an input with tokens of up to
+ * max_token_length characters. Lists and objects can be nested up to
+ * max_depth levels, deeper documents are aborted.
+ */
+template<typename Input, size_t max_token_length, size_t max_depth = 32u>
+using Reader = BasicReader<StoringTokenizer<Input, max_token_length, 2u, max_depth>>;
+
+/**
+ * Same as Reader, but stored strings are pinned in the buffer of the
+ * tokenizer instead of being copied (see PinningTokenizer). This saves the
+ * storage of two tokens of max_token_length characters.
+ */
+template<typename Input, size_t max_token_length, size_t max_depth = 32u>
+using PinningReader = BasicReader<PinningTokenizer<Input, max_token_length, 2u, max_depth>>;
+
+/**
+ * Reader for JSON documents which are completely in (writable) memory. It
+ * reads the document in place without copying it (see SpanTokenizer), so
+ * the document is modified and tokens are not limited in length.
+ */
+template<size_t max_depth = 32u>
+using SpanReader = BasicReader<SpanTokenizer<max_depth>>;
+
+template<typename Input, size_t max_token_length = 64u, size_t max_depth = 32u>
+Reader<Input, max_token_length, max_depth> makeReader(Input& input) {
+  return Reader<Input, max_token_length, max_depth>(input);
+}
+
+template<typename Input, size_t max_token_length = 64u, size_t max_depth = 32u>
+PinningReader<Input, max_token_length, max_depth> makePinningReader(Input& input) {
+  return PinningReader<Input, max_token_length, max_depth>(input);
+}
+
+/**
+ * Creates a SpanReader for the document, which must be terminated by a zero
+ * (i.e. document[length] == '\0').
+ */
+template<size_t max_depth = 32u>
+SpanReader<max_depth> makeReader(char* document, size_t length) {
+  return SpanReader<max_depth>(document, length);
+}
+
 }
 
 }
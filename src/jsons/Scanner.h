@@ -0,0 +1,256 @@
+#ifndef JSONS_SCANNER_H_
+#define JSONS_SCANNER_H_
+
+#include <cstdint>
+#include <cstring>
+
+/**
+ * Selection of the scanning implementation used for the dedicated character
+ * sets. It is picked at compile time based on the target, but can be forced
+ * by defining one of JSONS_SCAN_SSE2, JSONS_SCAN_SWAR or JSONS_SCAN_GENERIC.
+ *
+ * - SSE2: 16 characters at a time on x86 targets.
+ * - SWAR: one machine word at a time on 32/64-bit targets (e.g. ESP32).
+ * - GENERIC: the tokenizer uses strspn/strcspn for all sets (e.g. on AVR).
+ */
+#if !defined(JSONS_SCAN_SSE2) && !defined(JSONS_SCAN_SWAR) && !defined(JSONS_SCAN_GENERIC)
+#  if defined(__SSE2__)
+#    define JSONS_SCAN_SSE2
+#  elif defined(__AVR__)
+#    define JSONS_SCAN_GENERIC
+#  else
+#    define JSONS_SCAN_SWAR
+#  endif
+#endif
+
+#if defined(JSONS_SCAN_SSE2)
+#  include <emmintrin.h>
+#endif
+
+namespace jsons {
+
+/**
+ * A set of characters for the scanning functions of the tokenizer.
+ *
+ * The sets used by the reader have a specialised scanner, any other set of
+ * characters (implicitly converted from a string) is scanned generically.
+ */
+struct CharSet final {
+  enum struct Kind : uint8_t { Generic, StringDelimiters, ValueDelimiters, Whitespace, NumberChars };
+
+  Kind kind;
+  const char* chars;
+
+  constexpr CharSet(const char* chars) : kind(Kind::Generic), chars(chars) {}
+  constexpr CharSet(Kind kind, const char* chars) : kind(kind), chars(chars) {}
+};
+
+namespace chars {
+
+/** End of string contents, with '\' as escape character. */
+static constexpr CharSet STRING_DELIMITERS {CharSet::Kind::StringDelimiters, "\""};
+/** End of literals (null, true, false). */
+static constexpr CharSet VALUE_DELIMITERS {CharSet::Kind::ValueDelimiters, " \r\n\t,]}"};
+/** Insignificant whitespace between tokens. */
+static constexpr CharSet WHITESPACE {CharSet::Kind::Whitespace, " \r\n\t"};
+/** Characters of a number. */
+static constexpr CharSet NUMBER_CHARS {CharSet::Kind::NumberChars, "-+0123456789.eE"};
+
+}
+
+/**
+ * Scanning functions for the specialised character sets.
+ *
+ * All of them operate on a zero-terminated buffer and stop at the
+ * terminating zero at the latest. The end pointer must point behind the
+ * terminating zero and is only used to limit reads of multiple characters
+ * at once to the buffer.
+ */
+namespace scan {
+
+static inline bool isWhitespace(char c) {
+  return c == ' ' || c == '\r' || c == '\n' || c == '\t';
+}
+
+static inline bool isValueDelimiter(char c) {
+  return isWhitespace(c) || c == ',' || c == ']' || c == '}' || c == '\0';
+}
+
+static inline bool isNumberChar(char c) {
+  return (c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E';
+}
+
+static inline bool isStringDelimiter(char c) {
+  return c == '"' || c == '\\' || c == '\0';
+}
+
+#if defined(JSONS_SCAN_SWAR)
+namespace swar {
+
+using Word = uintptr_t;
+
+static constexpr Word ONES = ~Word(0) / 0xFF;
+static constexpr Word LOW_BITS = ONES * 0x7F;
+static constexpr Word HIGH_BITS = ONES * 0x80;
+
+static inline Word load(const char* p) {
+  Word word;
+  memcpy(&word, p, sizeof(word));
+  return word;
+}
+
+/** Sets the high bit of exactly those bytes which are zero. */
+static inline Word zeroBytes(Word word) {
+  return ~(((word & LOW_BITS) + LOW_BITS) | word | LOW_BITS);
+}
+
+static inline Word equalBytes(Word word, char c) {
+  return zeroBytes(word ^ (ONES * static_cast<uint8_t>(c)));
+}
+
+}
+#endif
+
+/**
+ * Returns the position of the first '"', '\' or the terminating zero.
+ */
+static inline const char* findStringDelimiter(const char* p, const char* end) {
+#if defined(JSONS_SCAN_SSE2)
+  const __m128i quote = _mm_set1_epi8('"');
+  const __m128i backslash = _mm_set1_epi8('\\');
+  const __m128i zero = _mm_setzero_si128();
+  while (p + sizeof(__m128i) <= end) {
+    const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    const __m128i matches = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash)), _mm_cmpeq_epi8(chunk, zero));
+    const int mask = _mm_movemask_epi8(matches);
+    if (mask != 0) {
+      return p + __builtin_ctz(mask);
+    }
+    p += sizeof(__m128i);
+  }
+#elif defined(JSONS_SCAN_SWAR)
+  while (p + sizeof(swar::Word) <= end) {
+    const swar::Word word = swar::load(p);
+    if ((swar::equalBytes(word, '"') | swar::equalBytes(word, '\\') | swar::zeroBytes(word)) != 0) {
+      break;
+    }
+    p += sizeof(swar::Word);
+  }
+#else
+  (void) end;
+#endif
+  while (!isStringDelimiter(*p)) {
+    ++p;
+  }
+  return p;
+}
+
+/**
+ * Returns the position of the first character which is not whitespace.
+ */
+static inline const char* skipWhitespace(const char* p, const char* end) {
+#if defined(JSONS_SCAN_SSE2)
+  const __m128i space = _mm_set1_epi8(' ');
+  const __m128i cr = _mm_set1_epi8('\r');
+  const __m128i lf = _mm_set1_epi8('\n');
+  const __m128i tab = _mm_set1_epi8('\t');
+  while (p + sizeof(__m128i) <= end) {
+    const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    const __m128i matches = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, space), _mm_cmpeq_epi8(chunk, cr)), _mm_or_si128(_mm_cmpeq_epi8(chunk, lf), _mm_cmpeq_epi8(chunk, tab)));
+    const int mask = _mm_movemask_epi8(matches) ^ 0xFFFF;
+    if (mask != 0) {
+      return p + __builtin_ctz(mask);
+    }
+    p += sizeof(__m128i);
+  }
+#elif defined(JSONS_SCAN_SWAR)
+  while (p + sizeof(swar::Word) <= end) {
+    const swar::Word word = swar::load(p);
+    if ((swar::equalBytes(word, ' ') | swar::equalBytes(word, '\r') | swar::equalBytes(word, '\n') | swar::equalBytes(word, '\t')) != swar::HIGH_BITS) {
+      break;
+    }
+    p += sizeof(swar::Word);
+  }
+#else
+  (void) end;
+#endif
+  while (isWhitespace(*p)) {
+    ++p;
+  }
+  return p;
+}
+
+static inline bool isStructuralChar(char c) {
+  return c == '"' || c == '[' || c == ']' || c == '{' || c == '}' || c == '\0';
+}
+
+/**
+ * Returns the position of the first '"', bracket or the terminating zero.
+ */
+static inline const char* findStructuralChar(const char* p, const char* end) {
+#if defined(JSONS_SCAN_SSE2)
+  const __m128i quote = _mm_set1_epi8('"');
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i listBegin = _mm_set1_epi8('[');
+  const __m128i listEnd = _mm_set1_epi8(']');
+  const __m128i objectBegin = _mm_set1_epi8('{');
+  const __m128i objectEnd = _mm_set1_epi8('}');
+  while (p + sizeof(__m128i) <= end) {
+    const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    const __m128i matches = _mm_or_si128(
+      _mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, zero)),
+      _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(chunk, listBegin), _mm_cmpeq_epi8(chunk, listEnd)),
+        _mm_or_si128(_mm_cmpeq_epi8(chunk, objectBegin), _mm_cmpeq_epi8(chunk, objectEnd))));
+    const int mask = _mm_movemask_epi8(matches);
+    if (mask != 0) {
+      return p + __builtin_ctz(mask);
+    }
+    p += sizeof(__m128i);
+  }
+#elif defined(JSONS_SCAN_SWAR)
+  while (p + sizeof(swar::Word) <= end) {
+    const swar::Word word = swar::load(p);
+    if ((swar::equalBytes(word, '"') | swar::zeroBytes(word)
+        | swar::equalBytes(word, '[') | swar::equalBytes(word, ']')
+        | swar::equalBytes(word, '{') | swar::equalBytes(word, '}')) != 0) {
+      break;
+    }
+    p += sizeof(swar::Word);
+  }
+#else
+  (void) end;
+#endif
+  while (!isStructuralChar(*p)) {
+    ++p;
+  }
+  return p;
+}
+
+/**
+ * Returns the position of the first character which ends a literal value.
+ */
+static inline const char* findValueDelimiter(const char* p, const char*) {
+  // literals are short, so checking each character is fastest
+  while (!isValueDelimiter(*p)) {
+    ++p;
+  }
+  return p;
+}
+
+/**
+ * Returns the position of the first character which cannot be part of a number.
+ */
+static inline const char* skipNumberChars(const char* p, const char*) {
+  // numbers are short, so checking each character is fastest
+  while (isNumberChar(*p)) {
+    ++p;
+  }
+  return p;
+}
+
+}
+
+}
+
+#endif
@@ -0,0 +1,177 @@
+#ifndef JSONS_SELECTOR_H_
+#define JSONS_SELECTOR_H_
+
+#include "Reader.h"
+
+namespace jsons {
+inline namespace JSONS_STATS_NAMESPACE {
+
+/**
+ * Selects values from a document by a set of paths in JSON pointer syntax
+ * (e.g. "/config/interval", with "~0" and "~1" for '~' and '/' in names),
+ * where a segment consisting of just '*' matches any property or list
+ * element. An empty path selects the root value.
+ *
+ * The document is walked once and the handler is called for each value
+ * matching one of the paths, with the index of the path and the value. Only
+ * lists and objects on the way to a selected value are iterated, everything
+ * else is skipped structurally (see Value::skip()).
+ *
+ * If the handler reads a selected list or object itself, paths below it are
+ * not matched anymore.
+ */
+template<size_t path_count>
+class Selector final {
+  const char* const* _paths;
+
+  /** The next segment of each path to be matched, nullptr if the path does not match. */
+  struct Cursor {
+    const char* segments[path_count];
+  };
+
+  /** Returns the segment after the given one, or nullptr if it is the last one. */
+  static const char* nextSegment(const char* segment) {
+    const char* end = strchr(segment, '/');
+    return end ? end + 1 : nullptr;
+  }
+
+  static bool isWildcard(const char* segment) {
+    return segment[0] == '*' && (segment[1] == '/' || segment[1] == '\0');
+  }
+
+  static bool matchesName(const char* segment, const char* name) {
+    if (isWildcard(segment)) {
+      return true;
+    }
+    while (*segment != '/' && *segment != '\0') {
+      char c = *segment;
+      if (c == '~') {
+        ++segment;
+        if (*segment == '0') {
+          c = '~';
+        } else if (*segment == '1') {
+          c = '/';
+        } else {
+          return false;
+        }
+      }
+      if (*name != c) {
+        return false;
+      }
+      ++segment;
+      ++name;
+    }
+    return *name == '\0';
+  }
+
+  static bool matchesIndex(const char* segment, size_t index) {
+    if (isWildcard(segment)) {
+      return true;
+    }
+    if (*segment == '/' || *segment == '\0' || (segment[0] == '0' && segment[1] != '/' && segment[1] != '\0')) {
+      return false; // empty or leading zero
+    }
+    size_t value = 0;
+    while (*segment != '/' && *segment != '\0') {
+      if (*segment < '0' || *segment > '9') {
+        return false;
+      }
+      value = value * 10 + (*segment - '0');
+      ++segment;
+    }
+    return value == index;
+  }
+
+  /**
+   * Matches the value at the current segments of the cursor and calls the
+   * handler or descends into it.
+   */
+  template<typename Tokenizer, typename Handler, typename Matcher>
+  void match(BasicValue<Tokenizer>& value, const Cursor& cursor, Handler& handler, const Matcher& matches) const {
+    // match all paths before calling any handler, which may replace the
+    // name of the property (a stored token) by reading the value
+    Cursor next;
+    bool selected[path_count];
+    bool descend = false;
+    for (size_t i = 0; i < path_count; ++i) {
+      next.segments[i] = nullptr;
+      selected[i] = false;
+      if (cursor.segments[i] && matches(cursor.segments[i])) {
+        const char* segment = nextSegment(cursor.segments[i]);
+        if (segment) {
+          next.segments[i] = segment;
+          descend = true;
+        } else {
+          selected[i] = true;
+        }
+      }
+    }
+
+    for (size_t i = 0; i < path_count; ++i) {
+      if (selected[i]) {
+        handler(i, value);
+      }
+    }
+
+    if (descend) {
+      selectIn(value, next, handler);
+    }
+  }
+
+  template<typename Tokenizer, typename Handler>
+  void selectIn(BasicValue<Tokenizer>& value, const Cursor& cursor, Handler& handler) const {
+    switch (value.type()) {
+      case ValueType::List:
+        {
+          size_t index = 0;
+          for (auto& element : value.asList()) {
+            match(element, cursor, handler, [index](const char* segment) { return matchesIndex(segment, index); });
+            ++index;
+          }
+        }
+        break;
+      case ValueType::Object:
+        for (auto& property : value.asObject()) {
+          const toolbox::strref name = property.name();
+          match(property, cursor, handler, [&name](const char* segment) { return matchesName(segment, name.cstr()); });
+        }
+        break;
+      default:
+        // nothing to select within other values
+        break;
+    }
+  }
+
+public:
+  constexpr Selector(const char* const (&paths)[path_count]) : _paths(paths) {}
+
+  template<typename Tokenizer, typename Handler>
+  void select(BasicValue<Tokenizer>& root, Handler& handler) const {
+    Cursor cursor;
+    bool descend = false;
+    for (size_t i = 0; i < path_count; ++i) {
+      cursor.segments[i] = nullptr;
+      if (_paths[i][0] == '\0') {
+        handler(i, root);
+      } else if (_paths[i][0] == '/') {
+        cursor.segments[i] = _paths[i] + 1;
+        descend = true;
+      }
+    }
+
+    if (descend) {
+      selectIn(root, cursor, handler);
+    }
+  }
+};
+
+template<size_t path_count>
+Selector<path_count> makeSelector(const char* const (&paths)[path_count]) {
+  return {paths};
+}
+
+}
+
+}
+
+#endif
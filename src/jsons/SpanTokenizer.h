@@ -0,0 +1,462 @@
+#ifndef JSONS_SPANTOKENIZER_H_
+#define JSONS_SPANTOKENIZER_H_
+
+#include "Tokenizer.h"
+
+namespace jsons {
+inline namespace JSONS_STATS_NAMESPACE {
+
+/**
+ * Tokenizer directly on a document which is completely in memory. Instead
+ * of copying the document into a buffer, tokens are terminated (and escape
+ * sequences decoded) in place, so the document is modified while it is
+ * read. Tokens are not limited in length.
+ *
+ * Stored tokens are not copied either, but stay where they are in the
+ * document. Strings are terminated at their closing '"' once it is
+ * consumed. Other tokens (i.e. numbers) are terminated right away, but the
+ * character after them is still needed to continue reading. It is saved
+ * with the stored token and put back while the tokenizer reads it, until
+ * it is consumed.
+ *
+ * The document must be terminated by a zero, i.e. document[length] == '\0'.
+ */
+template<size_t max_depth = 32u>
+class SpanTokenizer final : public IStoringTokenizer, public ReaderCounters {
+public:
+  static const size_t MAX_TOKENS = 2u;
+  static const size_t MAX_DEPTH = max_depth;
+
+private:
+  char* _document;
+  size_t _length;
+  bool _aborted;
+  toolbox::strref _abortReason;
+  size_t _start; // start of the current token
+  size_t _stopPosition;
+  char _stopChar;
+  size_t _escapePosition; // first possible escape character in the current token
+  bool _validateSkipped;
+  PackedStack<MAX_DEPTH, 1u> _structures; // lists (1) and objects (0) entered by the reader
+  const char* _storedTokens[MAX_TOKENS];
+  size_t _storedTerminators[MAX_TOKENS]; // where stored strings are terminated once their closing '"' is consumed
+  mutable size_t _storedEnds[MAX_TOKENS]; // where stored numbers are terminated, see terminateStoredNumbers()
+  char _storedEndChars[MAX_TOKENS]; // the characters at _storedEnds
+
+  bool terminated() const { return _document[_stopPosition] == '\0' && _stopPosition < _length; }
+
+  /** Terminates the stored strings of which the closing '"' is consumed. */
+  void terminateStoredStrings() {
+    for (size_t i = 0; i < MAX_TOKENS; ++i) {
+      if (_storedTerminators[i] < _start) {
+        _document[_storedTerminators[i]] = '\0';
+        _storedTerminators[i] = SIZE_MAX;
+      }
+    }
+  }
+
+  /**
+   * Terminates the stored numbers while the tokenizer waits right before the
+   * character after them, i.e. while nothing but the stored tokens is read.
+   * Stored numbers after which the tokenizer has moved on stay terminated.
+   */
+  void terminateStoredNumbers() {
+    for (size_t i = 0; i < MAX_TOKENS; ++i) {
+      if (_storedEnds[i] <= _start) {
+        _document[_storedEnds[i]] = '\0';
+      }
+      if (_storedEnds[i] < _start) {
+        _storedEnds[i] = SIZE_MAX;
+      }
+    }
+  }
+
+  /**
+   * Puts back the character after a stored number, which is needed to
+   * continue reading. The number is not terminated anymore then.
+   */
+  void restoreStoredNumbers() const {
+    for (size_t i = 0; i < MAX_TOKENS; ++i) {
+      if (_storedEnds[i] == _start) {
+        _document[_storedEnds[i]] = _storedEndChars[i];
+        _storedEnds[i] = SIZE_MAX;
+      }
+    }
+  }
+
+  void shiftToStopPosition() {
+    restoreStoredNumbers();
+    if (_stopPosition > _start || terminated()) {
+      _start = _stopPosition;
+      _document[_stopPosition] = _stopChar;
+    }
+    _stopPosition = _start;
+    _stopChar = _document[_start];
+    terminateStoredStrings();
+  }
+
+  void stopAt(const char* position) {
+    _stopPosition = position - _document;
+    _stopChar = *position;
+  }
+
+  bool isEscaped(char escapeChar) const {
+    bool escaped = false;
+    for (size_t i = _stopPosition; i > _start && _document[i - 1] == escapeChar; --i) {
+      escaped = !escaped;
+    }
+    return escaped;
+  }
+
+  /** Same as Tokenizer::findStringEnd(), on the document. */
+  const char* findStringEnd() {
+    const char* const end = _document + _length + 1;
+    const char* position = _document + _stopPosition;
+    _escapePosition = SIZE_MAX;
+    while (true) {
+      position = scan::findStringDelimiter(position, end);
+      if (*position != '\\') {
+        return position;
+      }
+      if (_escapePosition == SIZE_MAX) {
+        _escapePosition = position - _document;
+      }
+      if (*(position + 1) == '\0') {
+        return position + 1;
+      }
+      position += 2; // skip escaped character
+    }
+  }
+
+  void scanUntil(const CharSet& stopChars, char escapeChar) {
+    _escapePosition = _start;
+
+#if !defined(JSONS_SCAN_GENERIC)
+    switch (stopChars.kind) {
+      case CharSet::Kind::StringDelimiters:
+        if (escapeChar == '\\') {
+          stopAt(findStringEnd());
+          return;
+        }
+        break;
+      case CharSet::Kind::ValueDelimiters:
+        stopAt(scan::findValueDelimiter(_document + _stopPosition, _document + _length + 1));
+        return;
+      default:
+        break;
+    }
+#endif
+
+    while (_document[_stopPosition] != '\0') {
+      stopAt(_document + _stopPosition + strcspn(_document + _stopPosition, stopChars.chars));
+      if (isEscaped(escapeChar)) {
+        stopAt(_document + _stopPosition + 1);
+      } else {
+        break;
+      }
+    }
+  }
+
+  void scanWhile(const CharSet& stopChars, char escapeChar) {
+    _escapePosition = _start;
+
+#if !defined(JSONS_SCAN_GENERIC)
+    if (escapeChar == '\0') {
+      switch (stopChars.kind) {
+        case CharSet::Kind::Whitespace:
+          stopAt(scan::skipWhitespace(_document + _stopPosition, _document + _length + 1));
+          return;
+        case CharSet::Kind::NumberChars:
+          stopAt(scan::skipNumberChars(_document + _stopPosition, _document + _length + 1));
+          return;
+        default:
+          break;
+      }
+    }
+#endif
+
+    while (_document[_stopPosition] != '\0') {
+      stopAt(_document + _stopPosition + strspn(_document + _stopPosition, stopChars.chars));
+      if (isEscaped(escapeChar)) {
+        stopAt(_document + _stopPosition + 1);
+      } else {
+        break;
+      }
+    }
+  }
+
+public:
+  SpanTokenizer(char* document, size_t length) : _document(document), _length(length), _aborted(false), _abortReason(), _start(0), _stopPosition(0), _stopChar(document[0]), _escapePosition(0), _validateSkipped(false), _structures(), _storedTokens(), _storedTerminators(), _storedEnds(), _storedEndChars() {
+    for (size_t i = 0; i < MAX_TOKENS; ++i) {
+      _storedTokens[i] = "";
+      _storedTerminators[i] = SIZE_MAX;
+      _storedEnds[i] = SIZE_MAX;
+    }
+  }
+
+  size_t maxTokenLength() const override {
+    return _length;
+  }
+
+  void abort(const toolbox::strref& reason) override {
+    if (_aborted) {
+      return; // keep the original reason
+    }
+    _aborted = true;
+    _abortReason = reason;
+  }
+
+  bool aborted() const override {
+    return _aborted;
+  }
+
+  const toolbox::strref& abortReason() const override {
+    return _abortReason;
+  }
+
+  bool completed() const override {
+    return !aborted(); // all of the input is available right away
+  }
+
+  size_t positionInInput() const override {
+    return _start;
+  }
+
+  char stopChar() const override {
+    return _stopChar;
+  }
+
+  const char* current() const override {
+    restoreStoredNumbers(); // the input is inspected, so the stored numbers are not needed anymore
+    return _document + _start;
+  }
+
+  char peek(const char* chars) override {
+    if (aborted()) {
+      return '\0';
+    }
+
+    shiftToStopPosition();
+
+    if (_document[_start] != '\0' && strchr(chars, _document[_start])) {
+      return _document[_start];
+    } else {
+      return '\0';
+    }
+  }
+
+  void pop() override {
+    if (aborted()) {
+      return;
+    }
+
+    restoreStoredNumbers();
+    if (_stopPosition == _start && _document[_stopPosition] != '\0') {
+      _start += 1; // no current token, so remove a single character
+      _stopPosition = _start;
+      _stopChar = _document[_start];
+      terminateStoredStrings();
+    } else {
+      shiftToStopPosition();
+    }
+  }
+
+  char nextUntil(const CharSet& stopChars, char escapeChar = '\0') override {
+    if (aborted()) {
+      return '\0';
+    }
+
+    shiftToStopPosition();
+    scanUntil(stopChars, escapeChar);
+    _document[_stopPosition] = '\0';
+    return _stopChar;
+  }
+
+  char nextWhile(const CharSet& stopChars, char escapeChar = '\0') override {
+    if (aborted()) {
+      return '\0';
+    }
+
+    shiftToStopPosition();
+    scanWhile(stopChars, escapeChar);
+    _document[_stopPosition] = '\0';
+    return _stopChar;
+  }
+
+  void skip(const CharSet& chars = chars::WHITESPACE) override {
+    if (aborted()) {
+      return;
+    }
+
+    shiftToStopPosition();
+    scanWhile(chars, '\0');
+    _start = _stopPosition;
+    terminateStoredNumbers();
+  }
+
+  /**
+   * Decodes the escape sequences of the current token in place. As the
+   * decoded token is shorter, it is terminated before the stop position.
+   */
+  void handleEscapedChars(char escapeChar, EscapeHandler handler = &defaultEscapeHandler) override {
+    if (_escapePosition >= _stopPosition || _document[_stopPosition] != '\0') {
+      return; // no escape characters in the current token
+    }
+
+    const char* sourceEnd = &_document[_stopPosition];
+    const char* source = static_cast<const char*>(memchr(&_document[_escapePosition], escapeChar, sourceEnd - &_document[_escapePosition]));
+    if (source == nullptr) {
+      return;
+    }
+
+    char* destination = &_document[source - _document];
+    while (source < sourceEnd) {
+      if (*source == escapeChar) {
+        handler(&source, &destination);
+        countEscape();
+      } else {
+        *destination = *source;
+      }
+      ++destination;
+      ++source;
+    }
+    *destination = '\0';
+    _escapePosition = SIZE_MAX;
+  }
+
+  void truncate(size_t length) override {
+    if (_document[_stopPosition] == '\0' && _start + length < _stopPosition) {
+      _document[_stopPosition] = _stopChar;
+      _stopPosition = _start + length;
+      _stopChar = _document[_stopPosition];
+      _document[_stopPosition] = '\0';
+    }
+  }
+
+  /** Same as Tokenizer::skipStructure(), on the document. */
+  bool skipStructure(size_t depth = 0) override {
+    if (aborted()) {
+      return false;
+    }
+
+    shiftToStopPosition();
+
+    bool inString = false;
+    bool escaped = false;
+    const char* position = _document + _start;
+    const char* const end = _document + _length + 1;
+    while (*position != '\0') {
+      if (escaped) {
+        escaped = false;
+        ++position;
+      } else if (inString) {
+        position = scan::findStringDelimiter(position, end);
+        switch (*position) {
+          case '\\':
+            escaped = true;
+            ++position;
+            break;
+          case '"':
+            inString = false;
+            ++position;
+            break;
+        }
+      } else {
+        position = scan::findStructuralChar(position, end);
+        switch (*position) {
+          case '"':
+            inString = true;
+            break;
+          case '[':
+          case '{':
+            ++depth;
+            break;
+          case ']':
+          case '}':
+            if (depth <= 1) {
+              stopAt(position + 1);
+              _start = _stopPosition;
+              return true;
+            }
+            --depth;
+            break;
+          default:
+            continue; // end of the document
+        }
+        ++position;
+      }
+    }
+
+    stopAt(position);
+    _start = _stopPosition;
+    return false;
+  }
+
+  bool validateSkipped() const override {
+    return _validateSkipped;
+  }
+
+  void validateSkipped(bool enabled) {
+    _validateSkipped = enabled;
+  }
+
+  bool enterStructure(bool list) override {
+    if (!_structures.push(list ? 1u : 0u)) {
+      abort(F("Maximum nesting depth exceeded."));
+      return false;
+    }
+    countDepth(_structures.depth());
+    return true;
+  }
+
+  void leaveStructure() override {
+    _structures.pop();
+  }
+
+  size_t depth() const override {
+    return _structures.depth();
+  }
+
+  bool inList() const override {
+    return !_structures.empty() && _structures.top() == 1u;
+  }
+
+  size_t maxTokens() const override {
+    return MAX_TOKENS;
+  }
+
+  /**
+   * Stores the current token. The contents of a string (i.e. a token which
+   * stops at '"') just stay in the document, its closing '"' is replaced by
+   * the terminating zero once it is consumed. Other tokens stay terminated
+   * in the document, see terminateStoredNumbers().
+   */
+  void storeToken(size_t index) override {
+    if (index >= MAX_TOKENS) {
+      return;
+    }
+    _storedTokens[index] = _document + _start;
+    if (_stopChar == '"') {
+      _storedTerminators[index] = _stopPosition;
+      _storedEnds[index] = SIZE_MAX;
+    } else {
+      _storedTerminators[index] = SIZE_MAX;
+      _storedEnds[index] = _stopPosition;
+      _storedEndChars[index] = _stopChar;
+    }
+    countStored();
+  }
+
+  toolbox::strref storedToken(size_t index) const override {
+    if (index >= MAX_TOKENS) {
+      return {};
+    }
+    return _storedTokens[index];
+  }
+};
+
+}
+
+}
+
+#endif
@@ -0,0 +1,218 @@
+#ifndef JSONS_SPLITTER_H_
+#define JSONS_SPLITTER_H_
+
+#include <cstring>
+#include <toolbox/Maybe.h>
+#include <toolbox/String.h>
+#include "Scanner.h"
+
+namespace jsons {
+
+/** How the records of a document are delimited, see RecordSplitter. */
+enum struct RecordFormat {
+  Lines, // newline-delimited JSON, one record per (non-empty) line
+  ListElements // the elements of a list, which is the root value
+};
+
+/**
+ * A record of a document split by RecordSplitter. It is a document of its
+ * own, terminated by a zero (i.e. document[length] == '\0'), to be read with
+ * a SpanReader.
+ */
+struct Record {
+  size_t sequence; // index of the record within the document
+  char* document;
+  size_t length;
+};
+
+/**
+ * Splits a document which is completely in (writable) memory into records,
+ * e.g. to read them in parallel on several cores. Only the boundaries of
+ * the records are found, tracking just strings and the nesting of lists
+ * and objects (like Tokenizer::skipStructure()), which is much faster than
+ * reading them. The records themselves are not validated.
+ *
+ * The records are terminated in place, i.e. the newlines or ',' between
+ * them are replaced by zeros, so each one can be read by a SpanReader of
+ * its own (with its own tokenizer). Their sequence numbers allow to put
+ * the results back in order:
+ *
+ *   RecordSplitter splitter {document, length, RecordFormat::Lines};
+ *   while (auto record = splitter.next()) {
+ *     // hand the record to a worker, which reads it with
+ *     // makeReader(record.get().document, record.get().length)
+ *   }
+ *
+ * The document must be terminated by a zero, i.e. document[length] == '\0'.
+ */
+class RecordSplitter final {
+  char* _document;
+  size_t _length;
+  RecordFormat _format;
+  size_t _position; // start of the next record
+  size_t _sequence;
+  bool _opened; // whether the '[' of the list is consumed
+  bool _closed; // whether the ']' of the list is consumed
+  bool _failed;
+  toolbox::strref _errorMessage;
+
+  const char* end() const {
+    return _document + _length + 1;
+  }
+
+  void fail(const toolbox::strref& message) {
+    _failed = true;
+    _errorMessage = message;
+    _position = _length;
+  }
+
+  toolbox::Maybe<Record> split(size_t start, size_t stop) {
+    _document[stop] = '\0';
+    return {Record {_sequence++, _document + start, stop - start}};
+  }
+
+  toolbox::Maybe<Record> nextLine() {
+    while (_position < _length) {
+      const size_t start = _position;
+      const char* newline = static_cast<const char*>(memchr(_document + start, '\n', _length - start));
+      const size_t stop = newline != nullptr ? newline - _document : _length;
+      _position = stop < _length ? stop + 1 : _length;
+      _document[stop] = '\0';
+      if (*scan::skipWhitespace(_document + start, end()) != '\0') {
+        return split(start, stop);
+      }
+    }
+    return {};
+  }
+
+  /** Whether there is only whitespace from start up to stop (e.g. between two ','). */
+  bool isBlank(size_t start, size_t stop) const {
+    return scan::skipWhitespace(_document + start, end()) >= _document + stop;
+  }
+
+  /** Returns the position after the closing '"' of a string (or 0 if it is not closed). */
+  size_t skipString(size_t position) const {
+    const char* p = _document + position;
+    while (true) {
+      p = scan::findStringDelimiter(p, end());
+      if (*p == '"') {
+        return p + 1 - _document;
+      }
+      if (*p == '\0' || *(p + 1) == '\0') {
+        return 0u;
+      }
+      p += 2; // skip escaped character
+    }
+  }
+
+  toolbox::Maybe<Record> nextElement() {
+    if (!_opened) {
+      const char* p = scan::skipWhitespace(_document, end());
+      if (*p != '[') {
+        fail(F("Expected list of records."));
+        return {};
+      }
+      _opened = true;
+      _position = p + 1 - _document;
+    }
+    if (_closed) {
+      return {};
+    }
+
+    const size_t start = _position;
+    size_t position = start;
+    size_t depth = 0;
+    while (true) {
+      const char* p = _document + position;
+      if (depth == 0) {
+        while (!scan::isStructuralChar(*p) && *p != ',') {
+          ++p; // elements are separated by ',' at the top level only
+        }
+      } else {
+        p = scan::findStructuralChar(p, end());
+      }
+      position = p - _document;
+
+      switch (*p) {
+        case '"':
+          position = skipString(position + 1);
+          if (position == 0u) {
+            fail(F("Unexpected end of input in string."));
+            return {};
+          }
+          break;
+        case '[':
+        case '{':
+          ++depth;
+          ++position;
+          break;
+        case ']':
+        case '}':
+          if (depth > 0) {
+            --depth;
+            ++position;
+            break;
+          }
+          if (*p != ']') {
+            fail(F("Unexpected character in list."));
+            return {};
+          }
+          _closed = true;
+          _position = position + 1;
+          if (*scan::skipWhitespace(_document + _position, end()) != '\0') {
+            fail(F("Unexpected characters at end of document."));
+            return {};
+          }
+          if (isBlank(start, position)) {
+            if (_sequence == 0) {
+              return {}; // empty list
+            }
+            fail(F("Expected value in list."));
+            return {};
+          }
+          return split(start, position);
+        case ',':
+          if (isBlank(start, position)) {
+            fail(F("Expected value in list."));
+            return {};
+          }
+          _position = position + 1;
+          return split(start, position);
+        default:
+          fail(F("Unexpected end of input in list."));
+          return {};
+      }
+    }
+  }
+
+public:
+  RecordSplitter(char* document, size_t length, RecordFormat format) : _document(document), _length(length), _format(format), _position(0), _sequence(0), _opened(false), _closed(false), _failed(false), _errorMessage() {}
+
+  /**
+   * Returns the next record, or nothing at the end of the document (or if
+   * splitting failed, so check failed() after the last record).
+   */
+  toolbox::Maybe<Record> next() {
+    if (_failed) {
+      return {};
+    }
+    switch (_format) {
+      case RecordFormat::Lines:
+        return nextLine();
+      case RecordFormat::ListElements:
+        return nextElement();
+    }
+    return {};
+  }
+
+  /** Number of records split so far. */
+  size_t count() const { return _sequence; }
+
+  bool failed() const { return _failed; }
+
+  const toolbox::strref& errorMessage() const { return _errorMessage; }
+};
+
+}
+
+#endif
@@ -0,0 +1,75 @@
+#ifndef JSONS_STACK_H_
+#define JSONS_STACK_H_
+
+#include <cstdint>
+#include <cstddef>
+
+namespace jsons {
+
+/**
+ * Fixed-size stack of small values with only bits_per_level bits per level
+ * (e.g. the kind of the nested lists and objects), so deep nesting costs
+ * little memory.
+ *
+ * bits_per_level must divide 8, so that levels never span two bytes.
+ */
+template<size_t max_depth, uint8_t bits_per_level>
+class PackedStack final {
+public:
+  static const size_t MAX_DEPTH = max_depth;
+  static const uint8_t BITS_PER_LEVEL = bits_per_level;
+
+private:
+  static_assert(BITS_PER_LEVEL > 0u && 8u % BITS_PER_LEVEL == 0u, "bits_per_level must divide 8");
+
+  static const uint8_t LEVELS_PER_BYTE = 8u / BITS_PER_LEVEL;
+  static const uint8_t LEVEL_MASK = (1u << BITS_PER_LEVEL) - 1u;
+
+  uint8_t _levels[(MAX_DEPTH + LEVELS_PER_BYTE - 1u) / LEVELS_PER_BYTE + 1u] = {}; // add one to allow MAX_DEPTH of 0
+  size_t _depth = 0u;
+
+  uint8_t shift(size_t level) const { return (level % LEVELS_PER_BYTE) * BITS_PER_LEVEL; }
+
+public:
+  size_t depth() const { return _depth; }
+
+  bool empty() const { return _depth == 0u; }
+
+  bool full() const { return _depth == MAX_DEPTH; }
+
+  bool push(uint8_t value) {
+    if (full()) {
+      return false;
+    }
+    _depth += 1u;
+    replace(value);
+    return true;
+  }
+
+  /** Returns the top-most value, must not be called on an empty stack. */
+  uint8_t top() const {
+    const size_t level = _depth - 1u;
+    return (_levels[level / LEVELS_PER_BYTE] >> shift(level)) & LEVEL_MASK;
+  }
+
+  /** Replaces the top-most value, must not be called on an empty stack. */
+  void replace(uint8_t value) {
+    const size_t level = _depth - 1u;
+    uint8_t& byte = _levels[level / LEVELS_PER_BYTE];
+    byte = (byte & ~(LEVEL_MASK << shift(level))) | ((value & LEVEL_MASK) << shift(level));
+  }
+
+  bool pop() {
+    if (empty()) {
+      return false;
+    }
+    _depth -= 1u;
+    return true;
+  }
+
+  void clear() { _depth = 0u; }
+};
+
+}
+
+#endif
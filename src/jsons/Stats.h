@@ -0,0 +1,109 @@
+#ifndef JSONS_STATS_H_
+#define JSONS_STATS_H_
+
+#include <cstddef>
+
+/*
+ * The layout of tokenizers and writers depends on whether JSONS_STATS is
+ * defined, so everything built on them is declared in an inline namespace
+ * named after the setting. Translation units built with different settings
+ * thereby use different symbols, so passing the types between them fails
+ * to link instead of silently mixing layouts.
+ */
+#if defined(JSONS_STATS)
+#define JSONS_STATS_NAMESPACE stats_enabled
+#else
+#define JSONS_STATS_NAMESPACE stats_disabled
+#endif
+
+namespace jsons {
+inline namespace JSONS_STATS_NAMESPACE {
+
+/**
+ * Counters of the hot paths of the tokenizers, e.g. to size the maximum
+ * token length from real traffic. They are only maintained if JSONS_STATS
+ * is defined, otherwise they are all zero (and ReaderDiagnostics does not
+ * include them).
+ */
+struct ReaderStats {
+  size_t bytesRead; // characters read from the input
+  size_t refills; // reads from the input
+  size_t bytesMoved; // characters moved within the buffer
+  size_t tokensStored;
+  size_t escapesDecoded;
+  size_t peakDepth; // deepest nesting of lists and objects
+};
+
+/** Counters of the output of a writer, see ReaderStats. */
+struct WriterStats {
+  size_t writeCalls; // writes to the output
+  size_t bytesWritten;
+};
+
+#if defined(JSONS_STATS)
+
+class ReaderCounters {
+  ReaderStats _stats {};
+
+protected:
+  void countRead(size_t bytes) {
+    _stats.bytesRead += bytes;
+    _stats.refills += 1u;
+  }
+  void countMoved(size_t bytes) { _stats.bytesMoved += bytes; }
+  void countStored() { _stats.tokensStored += 1u; }
+  void countEscape() { _stats.escapesDecoded += 1u; }
+  void countDepth(size_t depth) {
+    if (depth > _stats.peakDepth) {
+      _stats.peakDepth = depth;
+    }
+  }
+
+public:
+  ReaderStats stats() const { return _stats; }
+};
+
+class WriterCounters {
+  WriterStats _stats {};
+
+protected:
+  void countWrite(size_t bytes) {
+    _stats.writeCalls += 1u;
+    _stats.bytesWritten += bytes;
+  }
+
+public:
+  WriterStats stats() const { return _stats; }
+};
+
+#else
+
+// without any members, so the counters take no space as (empty) base class
+
+class ReaderCounters {
+protected:
+  void countRead(size_t) {}
+  void countMoved(size_t) {}
+  void countStored() {}
+  void countEscape() {}
+  void countDepth(size_t) {}
+
+public:
+  ReaderStats stats() const { return {}; }
+};
+
+class WriterCounters {
+protected:
+  void countWrite(size_t) {}
+
+public:
+  WriterStats stats() const { return {}; }
+};
+
+#endif
+
+}
+
+}
+
+#endif
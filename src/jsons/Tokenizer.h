@@ -5,8 +5,20 @@
 #include <algorithm>
 #include <toolbox/Streams.h>
 #include <toolbox/String.h>
+#include "Scanner.h"
+#include "Stack.h"
+#include "Stats.h"
 
 namespace jsons {
+inline namespace JSONS_STATS_NAMESPACE {
+
+/**
+ * Function to decode an escape sequence starting at *source (the escape
+ * character) into *destination. It must leave both pointers at the last
+ * character read/written and return the number of characters by which the
+ * decoded sequence is shorter than the escape sequence.
+ */
+using EscapeHandler = size_t (*)(const char** source, char** destination);
 
 static size_t defaultEscapeHandler(const char** source, char** destination) {
   ++(*source);
@@ -26,16 +38,39 @@ public:
   virtual const char* current() const = 0;
   virtual char peek(const char* chars) = 0;
   virtual void pop() = 0;
-  virtual void skip(const char* chars = " \r\n\t") = 0;
-  virtual char nextUntil(const char* stopChars, char escapeChar = '\0') = 0;
-  virtual char nextWhile(const char* stopChars, char escapeChar = '\0') = 0;
-  virtual void handleEscapedChars(char escapeChar, std::function<size_t(const char** source, char** destination)> handler = &defaultEscapeHandler) = 0;
+  virtual void skip(const CharSet& chars = chars::WHITESPACE) = 0;
+  virtual char nextUntil(const CharSet& stopChars, char escapeChar = '\0') = 0;
+  virtual char nextWhile(const CharSet& stopChars, char escapeChar = '\0') = 0;
+  virtual void handleEscapedChars(char escapeChar, EscapeHandler handler = &defaultEscapeHandler) = 0;
+  virtual void truncate(size_t length) = 0;
+  virtual bool skipStructure(size_t depth = 0) = 0;
+  virtual bool validateSkipped() const = 0;
+  virtual bool enterStructure(bool list) = 0;
+  virtual void leaveStructure() = 0;
+  virtual size_t depth() const = 0;
+  virtual bool inList() const = 0;
 };
 
-template<typename Input, size_t max_token_length, typename Interface = ITokenizer>
-class Tokenizer : public Interface {
+/**
+ * Tokenizer on top of a buffer of MAX_TOKEN_LENGTH characters.
+ * 
+ * The current token starts at _bufferStart and ends at _stopPosition, where
+ * the character is replaced by a terminating zero (and stored in _stopChar).
+ * Consuming a token only moves the start of the buffer ahead. The remaining
+ * contents are moved to the beginning of the buffer only when a token does
+ * not fit into the rest of the buffer, so the cost of consuming a token does
+ * not depend on the size of the buffer.
+ *
+ * Up to max_pins consumed tokens can be pinned, i.e. kept in the buffer to
+ * be referenced later (see PinningTokenizer). Pinned tokens are kept at the
+ * beginning of the buffer and the contents are only moved to behind them.
+ */
+template<typename Input, size_t max_token_length, typename Interface = ITokenizer, size_t max_depth = 32u, size_t max_pins = 0u>
+class Tokenizer : public Interface, public ReaderCounters {
 public:
   static const size_t MAX_TOKEN_LENGTH = max_token_length;
+  static const size_t MAX_DEPTH = max_depth;
+  static const size_t MAX_PINS = max_pins;
 
 private:
   Input& _input;
@@ -43,43 +78,128 @@ private:
   bool _aborted;
   toolbox::strref _abortReason;
   char _buffer[MAX_TOKEN_LENGTH + 1]; // add terminating zero
+  size_t _bufferStart;
   size_t _bufferLength;
   size_t _stopPosition;
   char _stopChar;
+  size_t _escapePosition; // first possible escape character in the current token
+  bool _validateSkipped;
+  PackedStack<MAX_DEPTH, 1u> _structures; // lists (1) and objects (0) entered by the reader
+  struct Pin {
+    size_t start;
+    size_t end; // terminated once the character there is consumed
+  } _pins[MAX_PINS + 1]; // add one to allow MAX_PINS of 0
+  size_t _pendingPinEnd; // end of a pin which is not terminated yet
 
   void shiftBufferToStopPosition() {
-    if (_bufferLength > 0 && _buffer[_stopPosition] == '\0') {
-      size_t bufferSizeToShift = _bufferLength - _stopPosition + 1; // includes terminating zero
-      memmove(_buffer, _buffer + _stopPosition, bufferSizeToShift);
-      _bufferLength = bufferSizeToShift - 1; // subtract terminating zero
-      _stopPosition = 0;
+    if (_bufferLength > _bufferStart && _buffer[_stopPosition] == '\0') {
+      _bufferStart = _stopPosition;
       _buffer[_stopPosition] = _stopChar;
       _stopChar = '\0';
     }
+    if (MAX_PINS > 0u && _pendingPinEnd < _bufferStart) {
+      _buffer[_pendingPinEnd] = '\0';
+      _pendingPinEnd = SIZE_MAX;
+    }
+  }
+
+  /**
+   * Returns the position behind the pinned tokens (and their terminating
+   * zeros), where the buffer contents start at the earliest.
+   */
+  size_t pinsEnd() const {
+    size_t end = 0;
+    for (size_t i = 0; i < MAX_PINS; ++i) {
+      if (_pins[i].start != SIZE_MAX && _pins[i].end + 1 > end) {
+        end = _pins[i].end + 1;
+      }
+    }
+    return end;
+  }
+
+  /**
+   * Returns the lowest position for a pinned token of the given length
+   * (plus the terminating zero) which does not overlap other pinned tokens.
+   */
+  size_t freePinPosition(size_t length) const {
+    size_t position = 0;
+    bool overlaps = true;
+    while (overlaps) {
+      overlaps = false;
+      for (size_t i = 0; i < MAX_PINS; ++i) {
+        if (_pins[i].start != SIZE_MAX && _pins[i].start <= position + length && position <= _pins[i].end) {
+          position = _pins[i].end + 1;
+          overlaps = true;
+        }
+      }
+    }
+    return position;
   }
 
   void fillBuffer() {
+    if (_bufferStart == _bufferLength && _bufferLength > 0) {
+      // everything is consumed, so start over behind the pinned tokens for free
+      const size_t start = pinsEnd();
+      if (start < _bufferStart) {
+        _bufferStart = start;
+        _bufferLength = start;
+        _stopPosition = start;
+        _buffer[start] = '\0';
+      }
+    }
+
     if (_bufferLength < MAX_TOKEN_LENGTH && _input.available() > 0) {
       size_t charsRead = _input.readString(_buffer + _bufferLength, MAX_TOKEN_LENGTH - _bufferLength);
       _inputCharsRead += charsRead;
+      countRead(charsRead);
       _bufferLength += charsRead;
       _buffer[_bufferLength] = '\0';
     }
   }
 
+  /**
+   * Reads more input for a token which reaches the end of the buffered
+   * contents. Only if there is no more space at the end of the buffer, the
+   * contents are moved to the beginning of the buffer.
+   * 
+   * Returns true if more input was read.
+   */
+  bool refillBuffer() {
+    if (_input.available() == 0) {
+      return false;
+    }
+
+    if (_bufferLength == MAX_TOKEN_LENGTH && _bufferStart < _bufferLength) {
+      const size_t start = pinsEnd(); // pinned tokens are never moved
+      if (_bufferStart <= start) {
+        return false; // token is longer than the buffer (behind the pinned tokens)
+      }
+      size_t bufferSizeToShift = _bufferLength - _bufferStart + 1; // includes terminating zero
+      memmove(_buffer + start, _buffer + _bufferStart, bufferSizeToShift);
+      countMoved(bufferSizeToShift);
+      _bufferLength = start + bufferSizeToShift - 1; // subtract terminating zero
+      _stopPosition -= _bufferStart - start;
+      _bufferStart = start;
+    }
+
+    size_t inputCharsRead = _inputCharsRead;
+    fillBuffer();
+    return _inputCharsRead > inputCharsRead;
+  }
+
   /**
    * Function to check if the character at the current _stopPosition
    * is preceeded by an odd number of escape characters.
    */
   bool isEscaped(char escapeChar) const {
-    if (_stopPosition == 0 || _stopChar == '\0') {
+    if (_stopPosition == _bufferStart || _stopChar == '\0') {
       return false;
     }
 
     bool escaped = false;
 
     size_t i = _stopPosition;
-    while (i > 0) {
+    while (i > _bufferStart) {
       if (_buffer[i - 1] == escapeChar) {
         escaped = !escaped;
       } else {
@@ -91,8 +211,144 @@ private:
     return escaped;
   }
 
+  void stopAt(const char* position) {
+    _stopPosition = position - _buffer;
+    _stopChar = *position;
+  }
+
+  /**
+   * Returns the position of the first '"' which is not escaped by '\' or the
+   * terminating zero, starting at the current _stopPosition. Also records
+   * the position of the first escape character (if any).
+   */
+  const char* findStringEnd() {
+    const char* const end = _buffer + _bufferLength + 1;
+    const char* position = _buffer + _stopPosition;
+    _escapePosition = SIZE_MAX;
+    while (true) {
+      position = scan::findStringDelimiter(position, end);
+      if (*position != '\\') {
+        return position;
+      }
+      if (_escapePosition == SIZE_MAX) {
+        _escapePosition = position - _buffer;
+      }
+      if (*(position + 1) == '\0') {
+        return position + 1;
+      }
+      position += 2; // skip escaped character
+    }
+  }
+
+  void scanUntil(const CharSet& stopChars, char escapeChar) {
+    _stopPosition = _bufferStart;
+    _stopChar = _buffer[_stopPosition];
+    _escapePosition = _bufferStart;
+
+#if !defined(JSONS_SCAN_GENERIC)
+    switch (stopChars.kind) {
+      case CharSet::Kind::StringDelimiters:
+        if (escapeChar == '\\') {
+          stopAt(findStringEnd());
+          return;
+        }
+        break;
+      case CharSet::Kind::ValueDelimiters:
+        stopAt(scan::findValueDelimiter(_buffer + _stopPosition, _buffer + _bufferLength + 1));
+        return;
+      default:
+        break;
+    }
+#endif
+
+    while (_buffer[_stopPosition] != '\0') {
+      _stopPosition = _stopPosition + strcspn(_buffer + _stopPosition, stopChars.chars);
+      _stopChar = _buffer[_stopPosition];
+      if (isEscaped(escapeChar)) {
+        _stopPosition += 1;
+        _stopChar = _buffer[_stopPosition];
+      } else {
+        break;
+      }
+    };
+  }
+
+  void scanWhile(const CharSet& stopChars, char escapeChar) {
+    _stopPosition = _bufferStart;
+    _stopChar = _buffer[_stopPosition];
+    _escapePosition = _bufferStart;
+
+#if !defined(JSONS_SCAN_GENERIC)
+    if (escapeChar == '\0') {
+      switch (stopChars.kind) {
+        case CharSet::Kind::Whitespace:
+          stopAt(scan::skipWhitespace(_buffer + _stopPosition, _buffer + _bufferLength + 1));
+          return;
+        case CharSet::Kind::NumberChars:
+          stopAt(scan::skipNumberChars(_buffer + _stopPosition, _buffer + _bufferLength + 1));
+          return;
+        default:
+          break;
+      }
+    }
+#endif
+
+    while (_buffer[_stopPosition] != '\0') {
+      _stopPosition = _stopPosition + strspn(_buffer + _stopPosition, stopChars.chars);
+      _stopChar = _buffer[_stopPosition];
+      if (isEscaped(escapeChar)) {
+        _stopPosition += 1;
+        _stopChar = _buffer[_stopPosition];
+      } else {
+        break;
+      }
+    };
+  }
+
+protected:
+  /**
+   * Pins the current token, which must be followed by a character which is
+   * consumed right after it (e.g. the '"' after the contents of a string).
+   * 
+   * The token is moved to the lowest free position in the consumed part of
+   * the buffer, so pinned tokens gather at the beginning of the buffer and
+   * leave the rest of it to the following tokens. Once pinned, a token is
+   * not moved anymore until it is unpinned.
+   */
+  void pin(size_t index) {
+    unpin(index);
+    const size_t length = _stopPosition - _bufferStart;
+    const size_t position = freePinPosition(length);
+    if (position < _bufferStart) {
+      memmove(_buffer + position, _buffer + _bufferStart, length);
+      countMoved(length);
+      _buffer[position + length] = '\0';
+      _pins[index].start = position;
+      _pins[index].end = position + length;
+    } else {
+      // the character after the token is replaced by the terminating zero once it is consumed
+      _pins[index].start = _bufferStart;
+      _pins[index].end = _stopPosition;
+      _pendingPinEnd = _stopPosition;
+    }
+  }
+
+  void unpin(size_t index) {
+    if (_pins[index].start != SIZE_MAX && _pins[index].end == _pendingPinEnd) {
+      _pendingPinEnd = SIZE_MAX;
+    }
+    _pins[index].start = SIZE_MAX;
+  }
+
+  const char* pinned(size_t index) const {
+    return _pins[index].start != SIZE_MAX ? _buffer + _pins[index].start : nullptr;
+  }
+
 public:
-  Tokenizer(Input& input) : _input(input), _inputCharsRead(0), _aborted(false), _abortReason(), _buffer(), _bufferLength(0), _stopPosition(0), _stopChar('\0') {
+  Tokenizer(Input& input) : _input(input), _inputCharsRead(0), _aborted(false), _abortReason(), _buffer(), _bufferStart(0), _bufferLength(0), _stopPosition(0), _stopChar('\0'), _escapePosition(0), _validateSkipped(false), _structures(), _pins(), _pendingPinEnd(SIZE_MAX) {
+    for (size_t i = 0; i < MAX_PINS; ++i) {
+      _pins[i].start = SIZE_MAX;
+    }
   }
 
   size_t maxTokenLength() const override {
@@ -100,6 +356,9 @@ public:
   }
 
   void abort(const toolbox::strref& reason) override {
+    if (_aborted) {
+      return; // keep the original reason
+    }
     _aborted = true;
     _abortReason = reason;
   }
@@ -117,7 +376,7 @@ public:
   }
 
   size_t positionInInput() const override {
-    return _inputCharsRead - _bufferLength;
+    return _inputCharsRead - (_bufferLength - _bufferStart);
   }
 
   char stopChar() const override {
@@ -125,7 +384,7 @@ public:
   }
 
   const char* current() const override {
-    return _buffer;
+    return _buffer + _bufferStart;
   }
 
   char peek(const char* chars) override {
@@ -136,8 +395,8 @@ public:
     shiftBufferToStopPosition();
     fillBuffer();
 
-    if (strchr(chars, _buffer[0])) {
-      return _buffer[0];
+    if (strchr(chars, _buffer[_bufferStart])) {
+      return _buffer[_bufferStart];
     } else {
       return '\0';
     }
@@ -148,8 +407,9 @@ public:
       return;
     }
 
-    if (_stopPosition == 0 && _buffer[_stopPosition] != '\0') {
-      _stopPosition = 1;
+    if (_stopPosition == _bufferStart && _buffer[_stopPosition] != '\0') {
+      _escapePosition = _bufferStart;
+      _stopPosition = _bufferStart + 1;
       _stopChar = _buffer[_stopPosition];
       _buffer[_stopPosition] = '\0';
     }
@@ -158,7 +418,7 @@ public:
     fillBuffer();
   }
 
-  char nextUntil(const char* stopChars, char escapeChar = '\0') override {
+  char nextUntil(const CharSet& stopChars, char escapeChar = '\0') override {
     if (aborted()) {
       return '\0';
     }
@@ -166,21 +426,16 @@ public:
     shiftBufferToStopPosition();
     fillBuffer();
 
-    while (_buffer[_stopPosition] != '\0') {
-      _stopPosition = _stopPosition + strcspn(_buffer + _stopPosition, stopChars);
-      _stopChar = _buffer[_stopPosition];
-      if (isEscaped(escapeChar)) {
-        _stopPosition += 1;
-      } else {
-        break;
-      }
-    };
+    scanUntil(stopChars, escapeChar);
+    while (_stopPosition == _bufferLength && refillBuffer()) {
+      scanUntil(stopChars, escapeChar);
+    }
 
     _buffer[_stopPosition] = '\0';
     return _stopChar;
   }
 
-  char nextWhile(const char* stopChars, char escapeChar = '\0') override {
+  char nextWhile(const CharSet& stopChars, char escapeChar = '\0') override {
     if (aborted()) {
       return '\0';
     }
@@ -188,59 +443,196 @@ public:
     shiftBufferToStopPosition();
     fillBuffer();
 
-    while (_buffer[_stopPosition] != '\0') {
-      _stopPosition = _stopPosition + strspn(_buffer + _stopPosition, stopChars);
-      _stopChar = _buffer[_stopPosition];
-      if (isEscaped(escapeChar)) {
-        _stopPosition += 1;
-      } else {
-        break;
-      }
-    };
+    scanWhile(stopChars, escapeChar);
+    while (_stopPosition == _bufferLength && refillBuffer()) {
+      scanWhile(stopChars, escapeChar);
+    }
     
     _buffer[_stopPosition] = '\0';
     return _stopChar;
   }
 
-  void skip(const char* chars = " \r\n\t") override {
+  void skip(const CharSet& chars = chars::WHITESPACE) override {
     if (aborted()) {
       return;
     }
 
-    do {
-      shiftBufferToStopPosition();
-      fillBuffer();
-      _stopPosition = strspn(_buffer, chars);
-    } while (_buffer[_stopPosition] == '\0' && _input.available() > 0);
+    shiftBufferToStopPosition();
+    fillBuffer();
 
-    if (_stopPosition > 0 && strchr(chars, _buffer[_stopPosition - 1])) {
-      _stopChar = _buffer[_stopPosition];
-      _buffer[_stopPosition] = '\0';
-      shiftBufferToStopPosition();
+    scanWhile(chars, '\0');
+    while (_stopPosition == _bufferLength) {
+      _bufferStart = _stopPosition; // drop everything skipped so far
+      if (!refillBuffer()) {
+        break;
+      }
+      scanWhile(chars, '\0');
+    }
+
+    _bufferStart = _stopPosition;
+    _stopChar = '\0';
+  }
+
+  void handleEscapedChars(char escapeChar, EscapeHandler handler = &defaultEscapeHandler) override {
+    if (_escapePosition >= _stopPosition || _buffer[_stopPosition] != '\0') {
+      return; // no escape characters in the current token
+    }
+
+    const char* sourceEnd = &_buffer[_stopPosition];
+    const char* source = static_cast<const char*>(memchr(&_buffer[_escapePosition], escapeChar, sourceEnd - &_buffer[_escapePosition]));
+    if (source == nullptr) {
+      return;
+    }
+
+    // everything before the first escape character stays where it is
+    char* destination = &_buffer[source - _buffer];
+    size_t skippedChars = 0;
+    while (source < sourceEnd) {
+      if (*source == escapeChar) {
+        skippedChars += handler(&source, &destination);
+        countEscape();
+      } else {
+        *destination = *source;
+      }
+      ++destination;
+      ++source;
     }
+
+    if (skippedChars > 0) {
+      // move the (shorter) token up to the stop position, which only
+      // touches the token itself instead of the rest of the buffer
+      memmove(&_buffer[_bufferStart + skippedChars], &_buffer[_bufferStart], _stopPosition - _bufferStart - skippedChars);
+      countMoved(_stopPosition - _bufferStart - skippedChars);
+      _bufferStart += skippedChars;
+    }
+    _escapePosition = SIZE_MAX;
   }
 
-  void handleEscapedChars(char escapeChar, std::function<size_t(const char**, char**)> handler = &defaultEscapeHandler) override {
-    if (_bufferLength > 0 && _buffer[_stopPosition] == '\0') {
-      const char* source = &_buffer[0];
-      const char* sourceEnd = &_buffer[_stopPosition];
-      char* destination = &_buffer[0];
-      size_t skippedChars = 0;
-      while (source < sourceEnd) {
-        if (*source == escapeChar) {
-          skippedChars += handler(&source, &destination);
+  /**
+   * Skips a JSON list or object without tokenizing its contents. It only keeps
+   * track of the nesting depth and whether it is inside a string (including
+   * escaped characters), so the skipped contents are not validated.
+   * 
+   * With a depth of 0, it must start at the opening bracket. With a depth of 1
+   * (or more), it starts inside the list/object (but outside of a string) and
+   * skips everything up to and including the corresponding closing bracket(s).
+   * 
+   * Returns false if the input ended before the end of the structure.
+   */
+  bool skipStructure(size_t depth = 0) override {
+    if (aborted()) {
+      return false;
+    }
+
+    shiftBufferToStopPosition();
+    fillBuffer();
+
+    bool inString = false;
+    bool escaped = false;
+    while (true) {
+      const char* position = _buffer + _bufferStart;
+      const char* const end = _buffer + _bufferLength + 1;
+      while (*position != '\0') {
+        if (escaped) {
+          escaped = false;
+          ++position;
+        } else if (inString) {
+          position = scan::findStringDelimiter(position, end);
+          switch (*position) {
+            case '\\':
+              escaped = true;
+              ++position;
+              break;
+            case '"':
+              inString = false;
+              ++position;
+              break;
+          }
         } else {
-          *destination = *source;
+          position = scan::findStructuralChar(position, end);
+          switch (*position) {
+            case '"':
+              inString = true;
+              break;
+            case '[':
+            case '{':
+              ++depth;
+              break;
+            case ']':
+            case '}':
+              if (depth <= 1) {
+                _bufferStart = position + 1 - _buffer;
+                _stopPosition = _bufferStart;
+                _stopChar = '\0';
+                return true;
+              }
+              --depth;
+              break;
+            default:
+              continue; // end of buffer
+          }
+          ++position;
         }
-        ++destination;
-        ++source;
       }
-      *destination = *sourceEnd;
 
-      memmove(destination + 1, sourceEnd + 1, _bufferLength - _stopPosition - 1);
+      // all of the buffer is skipped, so it can be dropped
+      _bufferStart = _bufferLength;
+      _stopPosition = _bufferStart;
+      if (!refillBuffer()) {
+        return false;
+      }
+    }
+  }
+
+  /**
+   * Whether skipped lists and objects are fully parsed (and thereby
+   * validated) instead of using skipStructure(). Off by default.
+   */
+  bool validateSkipped() const override {
+    return _validateSkipped;
+  }
+
+  void validateSkipped(bool enabled) {
+    _validateSkipped = enabled;
+  }
+
+  /**
+   * Tracks the nesting of the lists and objects being read, which is
+   * limited to MAX_DEPTH levels to bound the stack usage of reading (and
+   * validating) nested values. Aborts if the limit is exceeded.
+   */
+  bool enterStructure(bool list) override {
+    if (!_structures.push(list ? 1u : 0u)) {
+      abort(F("Maximum nesting depth exceeded."));
+      return false;
+    }
+    countDepth(_structures.depth());
+    return true;
+  }
+
+  void leaveStructure() override {
+    _structures.pop();
+  }
+
+  size_t depth() const override {
+    return _structures.depth();
+  }
+
+  /** Whether the innermost structure entered is a list (or an object). */
+  bool inList() const override {
+    return !_structures.empty() && _structures.top() == 1u;
+  }
 
-      _stopPosition -= skippedChars;
-      _bufferLength -= skippedChars;
+  /**
+   * Shortens the current token to the given length. The remaining characters
+   * stay in the buffer and become part of the next token.
+   */
+  void truncate(size_t length) override {
+    if (_buffer[_stopPosition] == '\0' && _bufferStart + length < _stopPosition) {
+      _buffer[_stopPosition] = _stopChar;
+      _stopPosition = _bufferStart + length;
+      _stopChar = _buffer[_stopPosition];
+      _buffer[_stopPosition] = '\0';
     }
   }
 };
@@ -250,18 +642,20 @@ public:
   virtual size_t maxTokens() const = 0;
   virtual void storeToken(size_t index) = 0;
   virtual toolbox::strref storedToken(size_t index) const = 0;
+  /** Tells that a stored token is not needed anymore, see PinningTokenizer. */
+  virtual void releaseToken(size_t) {}
 };
 
-template<typename Input, size_t max_token_length, size_t max_tokens>
-class StoringTokenizer final : public Tokenizer<Input, max_token_length, IStoringTokenizer> {
+template<typename Input, size_t max_token_length, size_t max_tokens, size_t max_depth = 32u>
+class StoringTokenizer final : public Tokenizer<Input, max_token_length, IStoringTokenizer, max_depth> {
 public:
   static const size_t MAX_TOKENS = max_tokens;
 
 private:
-  char _tokenStorage[MAX_TOKENS][Tokenizer<Input, max_token_length, IStoringTokenizer>::MAX_TOKEN_LENGTH + 1];
+  char _tokenStorage[MAX_TOKENS][Tokenizer<Input, max_token_length, IStoringTokenizer, max_depth>::MAX_TOKEN_LENGTH + 1];
 
 public:
-  using Tokenizer<Input, max_token_length, IStoringTokenizer>::Tokenizer;
+  using Tokenizer<Input, max_token_length, IStoringTokenizer, max_depth>::Tokenizer;
 
   size_t maxTokens() const override {
     return MAX_TOKENS;
@@ -270,6 +664,7 @@ public:
   void storeToken(size_t index) override {
     if (index < MAX_TOKENS) {
       strcpy(_tokenStorage[index], this->current());
+      this->countStored();
     }
   }
 
@@ -282,6 +677,70 @@ public:
   }
 };
 
+/**
+ * Storing tokenizer which does not copy stored strings, but pins them in
+ * the buffer instead (see Tokenizer), so there is no separate storage of
+ * MAX_TOKENS times MAX_TOKEN_LENGTH characters. Other tokens (i.e. numbers)
+ * are copied to a small storage of max_stored_length characters, as the
+ * character after them is still needed.
+ *
+ * Pinned strings take up space in the buffer until they are released (a
+ * value when the next value is parsed, a property name when the next name
+ * is stored), so the maximum length of other tokens is reduced by their
+ * length meanwhile. Tokens which only do not fit into the buffer because of
+ * that abort reading with "Pinned tokens exhaust the buffer.", which means
+ * that max_token_length must be raised.
+ */
+template<typename Input, size_t max_token_length, size_t max_tokens, size_t max_depth = 32u, size_t max_stored_length = 24u>
+class PinningTokenizer final : public Tokenizer<Input, max_token_length, IStoringTokenizer, max_depth, max_tokens> {
+public:
+  static const size_t MAX_TOKENS = max_tokens;
+  static const size_t MAX_STORED_LENGTH = max_stored_length;
+
+private:
+  char _tokenStorage[MAX_TOKENS][MAX_STORED_LENGTH + 1];
+
+public:
+  using Tokenizer<Input, max_token_length, IStoringTokenizer, max_depth, max_tokens>::Tokenizer;
+
+  size_t maxTokens() const override {
+    return MAX_TOKENS;
+  }
+
+  void storeToken(size_t index) override {
+    if (index >= MAX_TOKENS) {
+      return;
+    }
+    if (this->stopChar() == '"') {
+      this->pin(index);
+      this->countStored();
+    } else if (strlen(this->current()) <= MAX_STORED_LENGTH) {
+      this->unpin(index);
+      strcpy(_tokenStorage[index], this->current());
+      this->countStored();
+    } else {
+      this->unpin(index);
+      this->abort(F("Token too long to be stored."));
+    }
+  }
+
+  toolbox::strref storedToken(size_t index) const override {
+    if (index >= MAX_TOKENS) {
+      return {};
+    }
+    const char* pinned = this->pinned(index);
+    return pinned ? pinned : _tokenStorage[index];
+  }
+
+  void releaseToken(size_t index) override {
+    if (index < MAX_TOKENS) {
+      this->unpin(index);
+    }
+  }
+};
+
+}
+
 }
 
-#endif
\ No newline at end of file
+#endif
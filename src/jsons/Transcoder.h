@@ -0,0 +1,170 @@
+#ifndef JSONS_TRANSCODER_H_
+#define JSONS_TRANSCODER_H_
+
+#include "EventParser.h"
+#include "Writer.h"
+
+namespace jsons {
+inline namespace JSONS_STATS_NAMESPACE {
+
+/** Keeps all properties with their names, see transcode(). */
+struct KeepProperties {
+  toolbox::Maybe<toolbox::strref> operator()(const toolbox::strref& name) const {
+    return {name};
+  }
+};
+
+/**
+ * Handler for an EventParser with raw strings, which writes the document
+ * to a writer with strings and numbers copied as they are.
+ *
+ * The names of properties are passed to rename, which returns the name to
+ * write instead (which may be the same) or nothing to drop the property.
+ */
+template<typename Rename>
+class TranscodingHandler final : public EventHandler {
+  IWriter& _writer;
+  const Rename& _rename;
+  size_t _skipping; // nesting within the value of a dropped property, plus one (0 if none)
+
+  /** Returns true if a primitive value is within a dropped property. */
+  bool skipValue() {
+    if (_skipping == 0u) {
+      return false;
+    }
+    if (_skipping == 1u) {
+      _skipping = 0u; // the dropped value is complete
+    }
+    return true;
+  }
+
+  bool skipOpen() {
+    if (_skipping == 0u) {
+      return false;
+    }
+    _skipping += 1u;
+    return true;
+  }
+
+  bool skipClose() {
+    if (_skipping == 0u) {
+      return false;
+    }
+    _skipping -= 1u;
+    if (_skipping == 1u) {
+      _skipping = 0u; // the dropped value is complete
+    }
+    return true;
+  }
+
+public:
+  TranscodingHandler(IWriter& writer, const Rename& rename) : _writer(writer), _rename(rename), _skipping(0u) {}
+
+  void onNull() {
+    if (!skipValue()) {
+      _writer.null();
+    }
+  }
+
+  void onBoolean(bool value) {
+    if (!skipValue()) {
+      _writer.boolean(value);
+    }
+  }
+
+  void onNumber(const Number& value) {
+    if (!skipValue()) {
+      _writer.numberLiteral(value.literal());
+    }
+  }
+
+  void onStringFragment(const toolbox::strref& fragment) {
+    if (_skipping == 0u) {
+      _writer.escapedString(fragment, true);
+    }
+  }
+
+  void onString(const toolbox::strref& value) {
+    if (!skipValue()) {
+      _writer.escapedString(value);
+    }
+  }
+
+  void onKey(const toolbox::strref& name) {
+    if (_skipping != 0u) {
+      return;
+    }
+    auto renamed = _rename(name);
+    if (renamed) {
+      _writer.escapedProperty(renamed.get());
+    } else {
+      _skipping = 1u;
+    }
+  }
+
+  void onOpenList() {
+    if (!skipOpen()) {
+      _writer.openList();
+    }
+  }
+
+  void onCloseList() {
+    if (!skipClose()) {
+      _writer.close();
+    }
+  }
+
+  void onOpenObject() {
+    if (!skipOpen()) {
+      _writer.openObject();
+    }
+  }
+
+  void onCloseObject() {
+    if (!skipClose()) {
+      _writer.close();
+    }
+  }
+};
+
+/** Outcome of transcode(). */
+class TranscodeResult final {
+  bool _failed;
+  ReaderDiagnostics _diagnostics;
+
+public:
+  TranscodeResult(bool failed, const ReaderDiagnostics& diagnostics) : _failed(failed), _diagnostics(diagnostics) {}
+
+  /** Whether reading the input or writing the output failed. */
+  bool failed() const { return _failed; }
+
+  /** The diagnostics of reading the input. */
+  const ReaderDiagnostics& diagnostics() const { return _diagnostics; }
+};
+
+/**
+ * Copies the document from the input to the writer (e.g. to minify it),
+ * without decoding and encoding strings and numbers: their tokens are
+ * written as they are in the document. Only the escape sequences in strings
+ * are checked. The writer is ended once the document is complete.
+ *
+ * Properties can be dropped or renamed with rename (see TranscodingHandler),
+ * which gets and returns names escaped as in the document.
+ */
+template<size_t max_token_length = 64u, size_t max_depth = 32u, typename Input, typename Rename = KeepProperties>
+TranscodeResult transcode(Input& input, IWriter& writer, const Rename& rename = {}) {
+  TranscodingHandler<Rename> handler {writer, rename};
+  EventParser<Input, TranscodingHandler<Rename>, max_token_length, max_depth, true> parser {handler, input};
+  parser.finished(true);
+  parser.parse();
+  if (!parser.failed()) {
+    writer.end();
+  }
+  return {parser.failed() || writer.failed(), parser.diagnostics()};
+}
+
+}
+
+}
+
+#endif
@@ -1,29 +1,431 @@
 #ifndef JSONS_WRITER_H_
 #define JSONS_WRITER_H_
 
+#include "Reader.h"
+#include "Stack.h"
+#include "Stats.h"
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <cstdlib>
+#include <algorithm>
+#include <type_traits>
 #include <toolbox/Decimal.h>
 #include <toolbox/Streams.h>
 #include <toolbox/String.h>
 
+#if defined(JSONS_CHECK_RAW)
+#  include "EventParser.h"
+#endif
+
 namespace jsons {
+inline namespace JSONS_STATS_NAMESPACE {
+
+namespace format {
+
+/** Maximum length of a formatted 64-bit integer ("-9223372036854775808"). */
+static const size_t MAX_INTEGER_LENGTH = 20u;
+
+/** Pairs of decimal digits from "00" to "99", to format two digits at once. */
+static constexpr char DIGIT_PAIRS[] =
+  "0001020304050607080910111213141516171819"
+  "2021222324252627282930313233343536373839"
+  "4041424344454647484950515253545556575859"
+  "6061626364656667686970717273747576777879"
+  "8081828384858687888990919293949596979899";
+
+template<typename Unsigned>
+static inline char* formatDigits(Unsigned magnitude, char* p) {
+  while (magnitude >= 100u) {
+    const size_t pair = static_cast<size_t>(magnitude % 100u) * 2u;
+    magnitude /= 100u;
+    *--p = DIGIT_PAIRS[pair + 1u];
+    *--p = DIGIT_PAIRS[pair];
+  }
+  if (magnitude >= 10u) {
+    const size_t pair = static_cast<size_t>(magnitude) * 2u;
+    *--p = DIGIT_PAIRS[pair + 1u];
+    *--p = DIGIT_PAIRS[pair];
+  } else {
+    *--p = static_cast<char>('0' + magnitude);
+  }
+  return p;
+}
+
+/**
+ * Formats the integer backwards from the end of the buffer (which must have
+ * room for MAX_INTEGER_LENGTH characters and the terminating zero) and
+ * returns the start of it.
+ */
+static inline char* formatInteger(int64_t value, char* end) {
+  const uint64_t magnitude = value < 0 ? 0u - static_cast<uint64_t>(value) : static_cast<uint64_t>(value);
+  char* p = end;
+  *--p = '\0';
+  // 32-bit divisions are a lot cheaper on small targets
+  if (magnitude <= UINT32_MAX) {
+    p = formatDigits(static_cast<uint32_t>(magnitude), p);
+  } else {
+    p = formatDigits(magnitude, p);
+  }
+  if (value < 0) {
+    *--p = '-';
+  }
+  return p;
+}
+
+/** Maximum length of a formatted double ("-2.2250738585072014e-308"). */
+static const size_t MAX_DOUBLE_LENGTH = 24u;
+
+/**
+ * Significant digits which are always enough to read a double back as the
+ * same value (17, or 9 where double only has 32 bits like on AVR).
+ */
+static const int MAX_DOUBLE_DIGITS = 1 + (DBL_MANT_DIG * 30103 + 99999) / 100000;
+
+/** Largest power of ten which a double represents exactly. */
+static const int MAX_EXACT_POWER = DBL_MANT_DIG > 24 ? 22 : 10;
+
+/**
+ * Returns value * 10^exponent, in steps of exact powers of ten so that each
+ * step is correctly rounded.
+ */
+static inline double scaleDecimal(double value, int exponent) {
+  while (exponent != 0) {
+    const int step = std::min(exponent < 0 ? -exponent : exponent, MAX_EXACT_POWER);
+    double power = 10.0;
+    for (int i = 1; i < step; ++i) {
+      power *= 10.0;
+    }
+    if (exponent < 0) {
+      value /= power;
+      exponent += step;
+    } else {
+      value *= power;
+      exponent -= step;
+    }
+  }
+  return value;
+}
+
+/**
+ * Formats the significant digits (with the first one at the given decimal
+ * exponent) like printf("%g") with the given precision, i.e. in exponential
+ * notation for exponents below -4 or from the precision on, and without
+ * trailing zeros.
+ */
+static inline char* formatSignificant(uint64_t digits, int exponent, int precision, char* p) {
+  while (digits % 10u == 0u) {
+    digits /= 10u;
+  }
+  char buffer[MAX_INTEGER_LENGTH + 1];
+  const char* first = formatDigits(digits, buffer + MAX_INTEGER_LENGTH);
+  const char* const last = buffer + MAX_INTEGER_LENGTH;
+  if (exponent < -4 || exponent >= precision) {
+    *p++ = *first++;
+    if (first != last) {
+      *p++ = '.';
+      while (first != last) {
+        *p++ = *first++;
+      }
+    }
+    *p++ = 'e';
+    *p++ = exponent < 0 ? '-' : '+';
+    const unsigned magnitude = static_cast<unsigned>(exponent < 0 ? -exponent : exponent);
+    if (magnitude < 10u) {
+      *p++ = '0';
+    }
+    char exponentBuffer[4];
+    const char* digit = formatDigits(magnitude, exponentBuffer + sizeof(exponentBuffer));
+    while (digit != exponentBuffer + sizeof(exponentBuffer)) {
+      *p++ = *digit++;
+    }
+  } else if (exponent < 0) {
+    *p++ = '0';
+    *p++ = '.';
+    for (int i = -1; i > exponent; --i) {
+      *p++ = '0';
+    }
+    while (first != last) {
+      *p++ = *first++;
+    }
+  } else {
+    for (int i = 0; i <= exponent; ++i) {
+      *p++ = first != last ? *first++ : '0';
+    }
+    if (first != last) {
+      *p++ = '.';
+      while (first != last) {
+        *p++ = *first++;
+      }
+    }
+  }
+  *p = '\0';
+  return p;
+}
+
+/**
+ * Formats the shortest representation of the (finite) value with 15 to 17
+ * significant digits (7 to 9 where double only has 32 bits) which reads
+ * back as the same value into the buffer, which must have room for
+ * MAX_DOUBLE_LENGTH characters and the terminating zero. The format is the
+ * one of printf("%.*g"), but printf is not used as it has no floating-point
+ * support on small targets (avr-libc prints '?').
+ */
+static inline void formatDouble(double value, char* buffer) {
+  char* p = buffer;
+  if (value < 0.0) {
+    *p++ = '-';
+    value = -value;
+  }
+  if (value == 0.0) {
+    p[0] = '0';
+    p[1] = '\0';
+    return;
+  }
+  int exponent = static_cast<int>(floor(log10(value)));
+  for (int precision = MAX_DOUBLE_DIGITS - 2; precision <= MAX_DOUBLE_DIGITS; ++precision) {
+    const uint64_t lowest = static_cast<uint64_t>(scaleDecimal(1.0, precision - 1));
+    uint64_t digits;
+    // log10() may be off by one near powers of ten, which the digits show
+    for (;;) {
+      digits = static_cast<uint64_t>(scaleDecimal(value, precision - 1 - exponent) + 0.5);
+      if (digits >= lowest * 10u) {
+        ++exponent;
+      } else if (digits < lowest) {
+        --exponent;
+      } else {
+        break;
+      }
+    }
+    // the scaling may be off by a few units in the last digit: the first
+    // correction scales the (exact) difference to the value read back, then
+    // the digits move towards the value one by one (with the most digits,
+    // there is always a match)
+    const int attempts = precision < MAX_DOUBLE_DIGITS ? 3 : 16;
+    for (int attempt = 0; attempt < attempts; ++attempt) {
+      formatSignificant(digits, exponent, precision, p);
+      const double parsed = strtod(p, nullptr);
+      if (parsed == value) {
+        return;
+      }
+      int64_t correction = 0;
+      if (attempt == 0 && parsed - parsed == 0.0) {
+        const double error = scaleDecimal(value - parsed, precision - 1 - exponent);
+        correction = static_cast<int64_t>(error + (error < 0.0 ? -0.5 : 0.5));
+      }
+      if (correction == 0) {
+        correction = parsed < value ? 1 : -1;
+      }
+      digits += static_cast<uint64_t>(correction);
+      if (digits >= lowest * 10u) {
+        digits = (digits + 5u) / 10u;
+        ++exponent;
+      } else if (digits < lowest) {
+        digits *= 10u;
+        --exponent;
+      }
+    }
+  }
+}
+
+}
 
 class IWriter {
 public:
+  /** Maximum length of strings written by the default escapedString(). */
+  static const size_t MAX_DECODED_LENGTH = 64u;
+
   virtual void null() = 0;
   virtual void boolean(const toolbox::Maybe<bool>& value) = 0;
   virtual void number(const toolbox::Maybe<int32_t>& value) = 0;
+  /** Writes the number with numberLiteral() by default. */
+  virtual void number(const toolbox::Maybe<int64_t>& value) {
+    if (value) {
+      char buffer[format::MAX_INTEGER_LENGTH + 1];
+      numberLiteral(format::formatInteger(value.get(), buffer + sizeof(buffer)));
+    } else {
+      null();
+    }
+  }
+  /**
+   * Writes the number with numberLiteral() by default, see the
+   * implementation of Writer.
+   */
+  virtual void number(const toolbox::Maybe<double>& value) {
+    if (value && value.get() - value.get() == 0.0) {
+      char buffer[format::MAX_DOUBLE_LENGTH + 1];
+      format::formatDouble(value.get(), buffer);
+      numberLiteral(buffer);
+    } else {
+      null();
+    }
+  }
   virtual void number(const toolbox::Maybe<const toolbox::Decimal&>& value) = 0;
+
+  /**
+   * Picks the matching overload for plain numbers (but not bool, see
+   * boolean()), which would be ambiguous between the different Maybe types
+   * otherwise. Unsigned 64-bit values beyond INT64_MAX are written as they are.
+   */
+  template<typename T, typename std::enable_if<std::is_arithmetic<T>::value && !std::is_same<T, bool>::value, int>::type = 0>
+  void number(T value) {
+    if (std::is_floating_point<T>::value) {
+      number(toolbox::Maybe<double>(static_cast<double>(value)));
+    } else if (sizeof(T) < sizeof(int32_t) || (sizeof(T) == sizeof(int32_t) && std::is_signed<T>::value)) {
+      number(toolbox::Maybe<int32_t>(static_cast<int32_t>(value)));
+    } else if (std::is_signed<T>::value || static_cast<uint64_t>(value) <= static_cast<uint64_t>(INT64_MAX)) {
+      number(toolbox::Maybe<int64_t>(static_cast<int64_t>(value)));
+    } else {
+      char buffer[format::MAX_INTEGER_LENGTH + 1];
+      char* end = buffer + sizeof(buffer);
+      *--end = '\0';
+      numberLiteral(format::formatDigits(static_cast<uint64_t>(value), end));
+    }
+  }
   virtual void string(const toolbox::Maybe<const char*>& value) = 0;
   virtual void string(const toolbox::Maybe<const __FlashStringHelper*>& value) = 0;
   virtual void string(const toolbox::Maybe<toolbox::strref>& value) = 0;
+  /**
+   * Writes a number literal as it is, which must be a valid JSON number. By
+   * default, it is written as 32-bit integer or Decimal, and fails the
+   * writer (see fail()) if it does not fit into either.
+   */
+  virtual void numberLiteral(const toolbox::strref& literal) {
+    int64_t integer;
+    const ValueType type = numberType(literal.cstr());
+    if (type == ValueType::Integer && parseInteger(literal.cstr(), integer) && integer >= INT32_MIN && integer <= INT32_MAX) {
+      number(toolbox::Maybe<int32_t>(static_cast<int32_t>(integer)));
+      return;
+    }
+    auto decimal = type != ValueType::Invalid ? toolbox::Decimal::fromString(literal) : toolbox::Maybe<toolbox::Decimal>();
+    if (decimal) {
+      number(toolbox::Maybe<const toolbox::Decimal&>(decimal.get()));
+    } else {
+      fail();
+    }
+  }
+  /**
+   * Writes a string with contents which are already escaped for JSON (e.g.
+   * as read by an EventParser with raw strings) as they are. A string can be
+   * written in fragments, with more set for all but the last one.
+   *
+   * By default, the escape sequences are decoded and the string is written
+   * with string(), which fails the writer (see fail()) for fragments and
+   * strings longer than MAX_DECODED_LENGTH.
+   */
+  virtual void escapedString(const toolbox::strref& contents, bool more = false) {
+    char buffer[MAX_DECODED_LENGTH + 1];
+    if (!more && decodeEscapes(contents.cstr(), buffer, MAX_DECODED_LENGTH)) {
+      string(toolbox::Maybe<toolbox::strref>(buffer));
+    } else {
+      fail();
+    }
+  }
+  /**
+   * Same as property(), with a name which is already escaped for JSON. By
+   * default, the name is decoded as with escapedString().
+   */
+  virtual IWriter& escapedProperty(const toolbox::strref& name) {
+    char buffer[MAX_DECODED_LENGTH + 1];
+    if (decodeEscapes(name.cstr(), buffer, MAX_DECODED_LENGTH)) {
+      return property(buffer);
+    }
+    fail();
+    return *this;
+  }
+  /**
+   * Writes an already serialized JSON value (e.g. a cached sub-document) as
+   * it is, with a single write to the output unless it fits into the buffer.
+   * It is only checked to be a single valid value if JSONS_CHECK_RAW is
+   * defined (e.g. for debug builds), the writer fails otherwise. Empty
+   * values (or only whitespace) always fail the writer.
+   *
+   * Fails the writer by default (see fail()), as the value cannot be
+   * written with the other methods without parsing it.
+   */
+  virtual void raw(const toolbox::strref&) {
+    fail();
+  }
+  /**
+   * Write a whole list of values at once, which is cheaper than opening a
+   * list and writing each value separately. The default implementations do
+   * just that, for implementations without a cheaper way.
+   */
+  virtual void list(const int32_t* values, size_t count) {
+    openList();
+    for (size_t i = 0; i < count; ++i) {
+      number(toolbox::Maybe<int32_t>(values[i]));
+    }
+    close();
+  }
+  virtual void list(const toolbox::Decimal* values, size_t count) {
+    openList();
+    for (size_t i = 0; i < count; ++i) {
+      number(toolbox::Maybe<const toolbox::Decimal&>(values[i]));
+    }
+    close();
+  }
+  virtual void list(const toolbox::strref* values, size_t count) {
+    openList();
+    for (size_t i = 0; i < count; ++i) {
+      string(toolbox::Maybe<toolbox::strref>(values[i]));
+    }
+    close();
+  }
+  virtual void list(const bool* values, size_t count) {
+    openList();
+    for (size_t i = 0; i < count; ++i) {
+      boolean(toolbox::Maybe<bool>(values[i]));
+    }
+    close();
+  }
   virtual void openList() = 0;
   virtual void openObject() = 0;
   virtual IWriter& property(const toolbox::strref& name) = 0;
   virtual void close() = 0;
   virtual void end() = 0;
+  /**
+   * Writes out any buffered output. Does nothing by default, i.e. for
+   * implementations without a buffer.
+   */
+  virtual void flush() {}
+  /**
+   * Fails the writer, which is used by the default implementations for
+   * values they cannot write. Does nothing by default, i.e. for
+   * implementations which cannot fail.
+   */
+  virtual void fail() {}
   virtual bool failed() const = 0;
 };
 
+/**
+ * Output which only counts the characters written, e.g. to send the exact
+ * Content-Length before the document itself. A Writer on it runs as a dry
+ * run: everything is formatted and escaped as usual to count the exact
+ * size, but no characters are copied.
+ */
+class SizeCounter final {
+  size_t _size = 0u;
+
+public:
+  size_t size() const { return _size; }
+
+  void reset() { _size = 0u; }
+
+  void add(size_t length) { _size += length; }
+
+  size_t write(char) {
+    _size += 1u;
+    return 1u;
+  }
+
+  size_t write(const toolbox::strref& chars) {
+    const size_t length = chars.length();
+    _size += length;
+    return length;
+  }
+};
+
 /**
  * Class template for writing JSON documents to a "Print-like" output with a
  * stream-oriented interface. It does not construct/store the whole document
@@ -38,9 +440,17 @@ public:
  * 
  * The Output type must adhere to the interface defined in IOutput, but it
  * does not actually have to have that class as a base class.
+ * 
+ * If buffer_size is non-zero, output is collected in a buffer of that size
+ * (inside the writer, i.e. usually on the stack) and only written to the
+ * output in bulk when the buffer is full, on end() or on an explicit flush().
+ * This reduces the number of (possibly expensive) write calls on the output.
+ *
+ * Lists and objects can be nested up to max_depth levels, each of which only
+ * takes two bits of memory.
  */
-template<typename Output>
-class Writer final : public IWriter {
+template<typename Output, size_t buffer_size = 0u, size_t max_depth = 20u>
+class Writer final : public IWriter, public WriterCounters {
   // JSON literals
   static const char SEPARATOR = ',';
   static const char OBJECT_BEGIN = '{';
@@ -61,6 +471,7 @@ class Writer final : public IWriter {
   static const uint8_t OPEN_OBJECT = 1 << 3;
   static const uint8_t START_PROPERTY = 1 << 4;
   static const uint8_t CLOSE = 1 << 5;
+  static const uint8_t CONTINUE_STRING = 1 << 6; // after a fragment of a string
 
   // States of data structures
   enum struct DataStructure : uint8_t {
@@ -71,48 +482,260 @@ class Writer final : public IWriter {
     List
   };
 
-  static const size_t MAX_STACK = 20u;
+  static const size_t MAX_DEPTH = max_depth;
+  static const size_t BUFFER_SIZE = buffer_size;
+  static const bool DRY_RUN = std::is_same<Output, SizeCounter>::value;
 
   Output& _output;
   bool _failed = false;
-  DataStructure _stack[MAX_STACK] = {DataStructure::None};
-  size_t _stackIndex = 0u;
+  char _buffer[BUFFER_SIZE + 1] = {}; // add terminating zero
+  size_t _bufferLength = 0u;
+  PackedStack<MAX_DEPTH, 2u> _stack; // DataStructure values without None
   uint8_t _allowed = INSERT_VALUE | INSERT_STRING | OPEN_LIST | OPEN_OBJECT;
 
   void allow(uint8_t allowed) { _allowed = allowed; }
 
   bool isAllowed(uint8_t op) const { return (_allowed & op) == op; }
 
-  bool isStackAvailable() const { return _stackIndex < MAX_STACK; }
+  bool push(DataStructure value) {
+    return _stack.push(static_cast<uint8_t>(value) - 1u);
+  }
 
-  bool isStackEmpty() const { return _stackIndex == 0u && _stack[_stackIndex] == DataStructure::None; }
+  DataStructure peek() const {
+    if (_stack.empty()) {
+      return DataStructure::None;
+    }
+    return static_cast<DataStructure>(_stack.top() + 1u);
+  }
 
-  bool push(DataStructure value) {
-    if (!isStackAvailable()) {
+  DataStructure pop() {
+    const DataStructure value = peek();
+    _stack.pop();
+    return value;
+  }
+
+  void replace(DataStructure value) {
+    if (!_stack.empty()) {
+      _stack.replace(static_cast<uint8_t>(value) - 1u);
+    }
+  }
+
+  size_t writeToOutput(char c) {
+    const size_t written = _output.write(c);
+    countWrite(written);
+    return written;
+  }
+
+  size_t writeToOutput(const toolbox::strref& chars) {
+    const size_t written = _output.write(chars);
+    countWrite(written);
+    return written;
+  }
+
+  static bool isBlank(const toolbox::strref& chars) {
+    const size_t length = chars.length();
+    for (size_t i = 0; i < length; ++i) {
+      const char c = chars.charAt(i);
+      if (c != ' ' && c != '\r' && c != '\n' && c != '\t') {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  bool flushBuffer() {
+    if (BUFFER_SIZE == 0u || _bufferLength == 0u) {
+      return true;
+    }
+    _buffer[_bufferLength] = '\0';
+    const size_t length = _bufferLength;
+    _bufferLength = 0u;
+    return writeToOutput(_buffer) == length;
+  }
+
+  bool write(char c) {
+    if (BUFFER_SIZE == 0u) {
+      return writeToOutput(c) == 1u;
+    }
+
+    if (_bufferLength == BUFFER_SIZE && !flushBuffer()) {
       return false;
     }
-    if (!isStackEmpty()) {
-      _stackIndex += 1;
+    _buffer[_bufferLength++] = c;
+    return true;
+  }
+
+  bool write(const char* chars, size_t length) {
+    return write(chars, length, std::integral_constant<bool, DRY_RUN>());
+  }
+
+  /** Only counts the characters for a SizeCounter, without copying them to the buffer or in chunks. */
+  bool write(const char*, size_t length, std::true_type) {
+    _output.add(length);
+    countWrite(length);
+    return true;
+  }
+
+  bool write(const char* chars, size_t length, std::false_type) {
+    const bool terminated = chars[length] == '\0';
+
+    if (BUFFER_SIZE == 0u) {
+      if (terminated) {
+        return writeToOutput(chars) == length;
+      }
+
+      // output can only take terminated strings, so pass it on in chunks
+      char chunk[32 + 1];
+      while (length > 0) {
+        const size_t chunkLength = std::min(length, sizeof(chunk) - 1);
+        memcpy(chunk, chars, chunkLength);
+        chunk[chunkLength] = '\0';
+        if (writeToOutput(chunk) != chunkLength) {
+          return false;
+        }
+        chars += chunkLength;
+        length -= chunkLength;
+      }
+      return true;
+    }
+
+    if (terminated && length > BUFFER_SIZE) {
+      // would not fit anyway, so write it directly
+      return flushBuffer() && writeToOutput(chars) == length;
+    }
+
+    while (length > 0) {
+      if (_bufferLength == BUFFER_SIZE && !flushBuffer()) {
+        return false;
+      }
+      const size_t chunkLength = std::min(length, BUFFER_SIZE - _bufferLength);
+      memcpy(_buffer + _bufferLength, chars, chunkLength);
+      _bufferLength += chunkLength;
+      chars += chunkLength;
+      length -= chunkLength;
     }
-    _stack[_stackIndex] = value;
     return true;
   }
 
-  DataStructure peek() { return _stack[_stackIndex]; }
+  bool write(const toolbox::strref& value) {
+    if (!value.isInProgmem()) {
+      return write(value.cstr(), value.length());
+    }
 
-  DataStructure pop() {
-    if (isStackEmpty()) {
-      return DataStructure::None;
+    const size_t length = value.length();
+
+    if (BUFFER_SIZE == 0u) {
+      return writeToOutput(value) == length;
     }
-    _stackIndex -= 1;
-    return _stack[_stackIndex + 1];
+
+    if (length > BUFFER_SIZE - _bufferLength) {
+      if (!flushBuffer()) {
+        return false;
+      }
+      if (length > BUFFER_SIZE) {
+        // would not fit anyway, so write it directly
+        return writeToOutput(value) == length;
+      }
+    }
+
+    for (size_t i = 0; i < length; ++i) {
+      _buffer[_bufferLength + i] = value.charAt(i);
+    }
+    _bufferLength += length;
+    return true;
   }
 
-  void replace(DataStructure value) {
-    _stack[_stackIndex] = value;
+  /**
+   * Returns the character to write after a '\' for characters which must be
+   * escaped in JSON strings, or '\0' if the character can be written as is.
+   * Control characters without a short form are escaped as \u00XX.
+   */
+  static char escapeFor(char c) {
+    switch (c) {
+      case '"': return '"';
+      case '\\': return '\\';
+      case '\b': return 'b';
+      case '\f': return 'f';
+      case '\n': return 'n';
+      case '\r': return 'r';
+      case '\t': return 't';
+      default: return static_cast<unsigned char>(c) < 0x20 ? 'u' : '\0';
+    }
+  }
+
+  static bool isPlain(char c) {
+    return static_cast<unsigned char>(c) >= 0x20 && c != '"' && c != '\\';
+  }
+
+  bool writeEscapedChar(char c) {
+    static const char HEX_DIGITS[] = "0123456789abcdef";
+    const char escape = escapeFor(c);
+    if (escape == '\0') {
+      return write(c);
+    }
+    if (escape == 'u') {
+      const char sequence[] = {'\\', 'u', '0', '0', HEX_DIGITS[(c >> 4) & 0x0F], HEX_DIGITS[c & 0x0F], '\0'};
+      return write(sequence, sizeof(sequence) - 1);
+    }
+    return write('\\') && write(escape);
+  }
+
+  bool writeEscaped(const toolbox::strref& value) {
+    if (value.isInProgmem()) {
+      const size_t length = value.length();
+      for (size_t i = 0; i < length; ++i) {
+        if (!writeEscapedChar(value.charAt(i))) {
+          return false;
+        }
+      }
+      return true;
+    }
+
+    // write runs of characters which need no escaping with a single write
+    const char* run = value.cstr();
+    while (true) {
+      const char* end = run;
+      while (isPlain(*end)) {
+        ++end;
+      }
+      if (end > run && !write(run, end - run)) {
+        return false;
+      }
+      if (*end == '\0') {
+        return true;
+      }
+      if (!writeEscapedChar(*end)) {
+        return false;
+      }
+      run = end + 1;
+    }
+  }
+
+  /**
+   * Writes a complete list, with the state of the writer only checked and
+   * updated once instead of for each element.
+   */
+  template<typename T, typename WriteElement>
+  void writeList(const T* values, size_t count, const WriteElement& writeElement) {
+    evaluate(OPEN_LIST, "");
+    if (_failed) {
+      return;
+    }
+    for (size_t i = 0u; i < count && !_failed; ++i) {
+      _failed = (i > 0u && !write(SEPARATOR)) || !writeElement(values[i]);
+    }
+    if (count > 0u) {
+      replace(DataStructure::List);
+    }
+    evaluate(CLOSE, "");
   }
 
-  void evaluate(uint8_t op, const toolbox::strref& value) {
+  /**
+   * Performs the operation if the current state allows it. Strings and
+   * property names are escaped unless they are already escaped, a string
+   * is left open for further fragments with more.
+   */
+  void evaluate(uint8_t op, const toolbox::strref& value, bool escaped = false, bool more = false) {
     if (_failed || !isAllowed(op)) {
       _failed = true;
       return;
@@ -121,19 +744,21 @@ class Writer final : public IWriter {
     switch (op) {
       case INSERT_VALUE:
         if (peek() == DataStructure::List) {
-          _failed = _failed || (_output.write(SEPARATOR) != 1u);
+          _failed = _failed || !write(SEPARATOR);
         }
         
-        _failed = _failed || (_output.write(value) != value.length());
+        _failed = _failed || !write(value);
 
         switch (peek()) {
           case DataStructure::EmptyObject:
             replace(DataStructure::Object);
+            // fall through
           case DataStructure::Object:
             allow(START_PROPERTY | CLOSE);
             break;
           case DataStructure::EmptyList:
             replace(DataStructure::List);
+            // fall through
           case DataStructure::List:
             allow(INSERT_VALUE | INSERT_STRING | OPEN_LIST | OPEN_OBJECT | CLOSE);
             break;
@@ -146,38 +771,31 @@ class Writer final : public IWriter {
         }
         break;
       case INSERT_STRING:
-        if (peek() == DataStructure::List) {
-          _failed = _failed || (_output.write(SEPARATOR) != 1u);
+      case CONTINUE_STRING:
+        if (op == INSERT_STRING) {
+          if (peek() == DataStructure::List) {
+            _failed = _failed || !write(SEPARATOR);
+          }
+          _failed = _failed || !write(STRING_BEGIN);
         }
 
-        _failed = _failed || (_output.write(STRING_BEGIN) != 1u);
-        {
-          const size_t length = value.length();
-          size_t i = 0;
-          while (!_failed && i < length) {
-            char c = value.charAt(i);
-            switch (c)
-            {
-            case '\\':
-            case '"':
-              _failed = _failed || (_output.write('\\') != 1);
-            default:
-              _failed = _failed || (_output.write(c) != 1);
-              break;
-            }
-            ++i;
-          }
+        _failed = _failed || !(escaped ? write(value) : writeEscaped(value));
+        if (more) {
+          allow(CONTINUE_STRING);
+          break;
         }
-        _failed = _failed || (_output.write(STRING_END) != 1u);
+        _failed = _failed || !write(STRING_END);
 
         switch (peek()) {
           case DataStructure::EmptyObject:
             replace(DataStructure::Object);
+            // fall through
           case DataStructure::Object:
             allow(START_PROPERTY | CLOSE);
             break;
           case DataStructure::EmptyList:
             replace(DataStructure::List);
+            // fall through
           case DataStructure::List:
             allow(INSERT_VALUE | INSERT_STRING | OPEN_LIST | OPEN_OBJECT | CLOSE);
             break;
@@ -195,14 +813,14 @@ class Writer final : public IWriter {
             replace(DataStructure::List);
             break;
           case DataStructure::List:
-            _failed = _failed || (_output.write(SEPARATOR) != 1u);
+            _failed = _failed || !write(SEPARATOR);
             break;
           default:
             // nothing
             break;
         }
 
-        _failed = _failed || (_output.write(LIST_BEGIN) != 1u);
+        _failed = _failed || !write(LIST_BEGIN);
         _failed = _failed || !push(DataStructure::EmptyList);
         allow(INSERT_VALUE | INSERT_STRING | OPEN_LIST | OPEN_OBJECT | CLOSE);
         break;
@@ -212,14 +830,14 @@ class Writer final : public IWriter {
             replace(DataStructure::List);
             break;
           case DataStructure::List:
-            _failed = _failed || (_output.write(SEPARATOR) != 1u);
+            _failed = _failed || !write(SEPARATOR);
             break;
           default:
             // nothing
             break;
         }
         
-        _failed = _failed || (_output.write(OBJECT_BEGIN) != 1u);
+        _failed = _failed || !write(OBJECT_BEGIN);
         _failed = _failed || !push(DataStructure::EmptyObject);
         allow(START_PROPERTY | CLOSE);
         break;
@@ -229,39 +847,23 @@ class Writer final : public IWriter {
             replace(DataStructure::Object);
             break;
           case DataStructure::Object:
-            _failed = _failed || (_output.write(SEPARATOR) != 1u);
+            _failed = _failed || !write(SEPARATOR);
             break;
           default:
             _failed = true;
             break;
         }
-        _failed = _failed || (_output.write(PROPERTY_BEGIN) != 1u);
-        {
-          const size_t length = value.length();
-          size_t i = 0;
-          while (!_failed && i < length) {
-            char c = value.charAt(i);
-            switch (c)
-            {
-            case '\\':
-            case '"':
-              _failed = _failed || (_output.write('\\') != 1);
-            default:
-              _failed = _failed || (_output.write(c) != 1);
-              break;
-            }
-            ++i;
-          }
-        }
-        _failed = _failed || (_output.write(PROPERTY_END) != 1u);
-        _failed = _failed || (_output.write(PROPERTY_VALUE_SEPARATOR) != 1u);
+        _failed = _failed || !write(PROPERTY_BEGIN);
+        _failed = _failed || !(escaped ? write(value) : writeEscaped(value));
+        _failed = _failed || !write(PROPERTY_END);
+        _failed = _failed || !write(PROPERTY_VALUE_SEPARATOR);
         allow(INSERT_VALUE | INSERT_STRING | OPEN_LIST | OPEN_OBJECT);
         break;
       case CLOSE:
         switch (pop()) {
           case DataStructure::EmptyObject:
           case DataStructure::Object:
-            _failed = _failed || (_output.write(OBJECT_END) != 1u);
+            _failed = _failed || !write(OBJECT_END);
             switch (peek()) {
               case DataStructure::EmptyObject:
               case DataStructure::Object:
@@ -278,7 +880,7 @@ class Writer final : public IWriter {
             break;
           case DataStructure::EmptyList:
           case DataStructure::List:
-            _failed = _failed || (_output.write(LIST_END) != 1u);
+            _failed = _failed || !write(LIST_END);
             switch (peek()) {
               case DataStructure::EmptyObject:
               case DataStructure::Object:
@@ -323,10 +925,34 @@ public:
     }
   }
 
+  using IWriter::number;
+
   void number(const toolbox::Maybe<int32_t>& value) override {
-    static char buffer[12];
     if (value) {
-      snprintf(buffer, std::size(buffer), "%i", value.get());
+      char buffer[format::MAX_INTEGER_LENGTH + 1];
+      evaluate(INSERT_VALUE, format::formatInteger(value.get(), buffer + sizeof(buffer)));
+    } else {
+      null();
+    }
+  }
+
+  void number(const toolbox::Maybe<int64_t>& value) override {
+    if (value) {
+      char buffer[format::MAX_INTEGER_LENGTH + 1];
+      evaluate(INSERT_VALUE, format::formatInteger(value.get(), buffer + sizeof(buffer)));
+    } else {
+      null();
+    }
+  }
+
+  /**
+   * Writes the shortest representation which reads back as the same value.
+   * NaN and infinity cannot be represented in JSON and are written as null.
+   */
+  void number(const toolbox::Maybe<double>& value) override {
+    if (value && value.get() - value.get() == 0.0) {
+      char buffer[format::MAX_DOUBLE_LENGTH + 1];
+      format::formatDouble(value.get(), buffer);
       evaluate(INSERT_VALUE, buffer);
     } else {
       null();
@@ -365,6 +991,55 @@ public:
     }
   }
 
+  void numberLiteral(const toolbox::strref& literal) override {
+    evaluate(INSERT_VALUE, literal);
+  }
+
+  void escapedString(const toolbox::strref& contents, bool more = false) override {
+    evaluate(isAllowed(CONTINUE_STRING) ? CONTINUE_STRING : INSERT_STRING, contents, true, more);
+  }
+
+  void raw(const toolbox::strref& json) override {
+    if (isBlank(json)) {
+      _failed = true; // would leave a separator without a value
+      return;
+    }
+#if defined(JSONS_CHECK_RAW)
+    toolbox::StringInput input {json};
+    if (!_failed && validate(input).failed()) {
+      _failed = true;
+      return;
+    }
+#endif
+    evaluate(INSERT_VALUE, json);
+  }
+
+  void list(const int32_t* values, size_t count) override {
+    writeList(values, count, [this](int32_t value) {
+      char buffer[format::MAX_INTEGER_LENGTH + 1];
+      const char* number = format::formatInteger(value, buffer + sizeof(buffer));
+      return write(number, buffer + format::MAX_INTEGER_LENGTH - number);
+    });
+  }
+
+  void list(const toolbox::Decimal* values, size_t count) override {
+    writeList(values, count, [this](const toolbox::Decimal& value) {
+      return write(value.toString());
+    });
+  }
+
+  void list(const toolbox::strref* values, size_t count) override {
+    writeList(values, count, [this](const toolbox::strref& value) {
+      return write(STRING_BEGIN) && writeEscaped(value) && write(STRING_END);
+    });
+  }
+
+  void list(const bool* values, size_t count) override {
+    writeList(values, count, [this](bool value) {
+      return value ? write("true", 4u) : write("false", 5u);
+    });
+  }
+
   void openList() override {
     evaluate(OPEN_LIST, "");
   }
@@ -378,21 +1053,38 @@ public:
     return *this;
   }
 
+  IWriter& escapedProperty(const toolbox::strref& name) override {
+    evaluate(START_PROPERTY, name, true);
+    return *this;
+  }
+
   void close() override {
     evaluate(CLOSE, "");
   }
 
   void end() override {
+    if (!failed() && isAllowed(CONTINUE_STRING)) {
+      evaluate(CONTINUE_STRING, "", true); // end a string written in fragments
+    }
     while (!failed() && peek() != DataStructure::None) {
       close();
     }
+    flush();
+  }
+
+  void flush() override {
+    _failed = !flushBuffer() || _failed;
   }
 
+  void fail() override { _failed = true; }
+
   bool failed() const override { return _failed; }
 };
 
-template<typename Output>
-Writer<Output> makeWriter(Output& output) { return {output}; }
+template<typename Output, size_t buffer_size = 0u, size_t max_depth = 20u>
+Writer<Output, buffer_size, max_depth> makeWriter(Output& output) { return {output}; }
+
+}
 
 }
 
@@ -0,0 +1,25 @@
+#ifndef JSONS_TEST_H_
+#define JSONS_TEST_H_
+
+#include <cstdio>
+#include <string>
+#include <jsons.h>
+
+/*
+ * Minimal test support for the host tests: CHECK() reports failed
+ * conditions and TEST_RESULT() is the exit code of main().
+ */
+
+static int testFailures = 0;
+
+#define CHECK(condition) \
+  do { \
+    if (!(condition)) { \
+      printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+      ++testFailures; \
+    } \
+  } while (false)
+
+#define TEST_RESULT() (testFailures == 0 ? 0 : 1)
+
+#endif
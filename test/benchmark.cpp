@@ -0,0 +1,70 @@
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "../examples/benchmark/Benchmark.h"
+
+/*
+ * Runs the benchmarks of the benchmark sketch on the host, on its corpus or
+ * on the JSON documents given as arguments (e.g. the real twitter.json and
+ * canada.json), which are repeated within a list. Prints the results as
+ * tab-separated values and fails if any document could not be processed.
+ */
+
+static bool failed = false;
+
+static unsigned long now() {
+  using namespace std::chrono;
+  return static_cast<unsigned long>(duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count());
+}
+
+static void printResult(const Result& result) {
+  printf("%s\t%s\t%zu\t", result.what, result.corpus.name, result.maxTokenLength);
+  if (result.failed) {
+    printf("FAILED\n");
+    failed = true;
+    return;
+  }
+  printf("%.3f MB/s\t", result.micros > 0u ? static_cast<double>(result.bytes) / result.micros : 0.0);
+  if (result.values == 0u) {
+    printf("-\n"); // not counted
+    return;
+  }
+  printf("%.1f ns/value\n", static_cast<double>(result.micros) * 1000.0 / result.values);
+}
+
+static void run(const Corpus& corpus) {
+  benchmark<32u>(corpus, &now, &printResult);
+  benchmark<64u>(corpus, &now, &printResult);
+  benchmark<128u>(corpus, &now, &printResult);
+}
+
+int main(int argc, char** argv) {
+  printf("what\tcorpus\tmax_token_length\tthroughput\ttime per value\n");
+  if (argc < 2) {
+    for (const Corpus& corpus : CORPORA) {
+      run(corpus);
+    }
+    return failed ? 1 : 0;
+  }
+
+  std::vector<std::string> documents;
+  for (int i = 1; i < argc; ++i) {
+    std::ifstream file {argv[i], std::ios::binary};
+    if (!file) {
+      fprintf(stderr, "Cannot read %s\n", argv[i]);
+      return 2;
+    }
+    std::stringstream contents;
+    contents << file.rdbuf();
+    documents.push_back(contents.str());
+  }
+  for (int i = 1; i < argc; ++i) {
+    // repeat small documents to get to about 1 MB, for a more precise measurement
+    const size_t count = std::max<size_t>(1u, (1u << 20) / std::max<size_t>(1u, documents[i - 1].size()));
+    run({argv[i], documents[i - 1].c_str(), count});
+  }
+  return failed ? 1 : 0;
+}
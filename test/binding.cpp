@@ -0,0 +1,126 @@
+#include "Test.h"
+
+namespace test {
+
+struct Sensor {
+  int32_t id;
+  char name[8];
+};
+JSONS_BIND(Sensor, id, name)
+
+struct Config {
+  int32_t interval;
+  char ssid[8];
+  Sensor sensors[2];
+  int16_t levels[3];
+  bool enabled;
+  double ratio;
+  int64_t smallest;
+  uint64_t largest;
+  uint8_t byte;
+};
+JSONS_BIND(Config, interval, ssid, sensors, levels, enabled, ratio, smallest, largest, byte)
+
+}
+
+/** Reads the document into the config, returns false if reading failed. */
+static bool read(const std::string& document, test::Config& config) {
+  toolbox::StringInput input {document.c_str()};
+  jsons::Reader<toolbox::IInput, 32u> reader {input};
+  {
+    auto root = reader.begin();
+    jsons::read(root, config);
+  }
+  reader.end();
+  return !reader.failed();
+}
+
+static std::string write(const test::Config& config) {
+  toolbox::StringOutput output;
+  auto writer = jsons::makeWriter(output);
+  jsons::write(writer, config);
+  writer.end();
+  return writer.failed() ? "failed" : output.out;
+}
+
+static test::Config defaults() {
+  test::Config config {};
+  config.interval = 10;
+  strcpy(config.ssid, "none");
+  return config;
+}
+
+int main() {
+  // nested structs, lists and unknown properties, which are skipped structurally
+  {
+    test::Config config = defaults();
+    CHECK(read("{\"sensors\":[{\"id\":1,\"name\":\"in\"},{\"name\":\"out\",\"id\":2,\"unit\":\"C\"}],"
+      "\"unknown\":{\"a\":[1,{\"b\":\"]}\"}],\"c\":null},\"levels\":[-1,2],\"enabled\":true,\"ratio\":0.25,\"ssid\":\"home\"}", config));
+    CHECK(config.sensors[0].id == 1);
+    CHECK(strcmp(config.sensors[0].name, "in") == 0);
+    CHECK(config.sensors[1].id == 2);
+    CHECK(strcmp(config.sensors[1].name, "out") == 0);
+    CHECK(config.levels[0] == -1 && config.levels[1] == 2 && config.levels[2] == 0);
+    CHECK(config.enabled);
+    CHECK(config.ratio == 0.25);
+    CHECK(strcmp(config.ssid, "home") == 0);
+    // missing fields are left as they are
+    CHECK(config.interval == 10);
+    CHECK(config.largest == 0u);
+  }
+
+  // null leaves the field as it is
+  {
+    test::Config config = defaults();
+    CHECK(read("{\"interval\":null,\"ssid\":null}", config));
+    CHECK(config.interval == 10);
+    CHECK(strcmp(config.ssid, "none") == 0);
+  }
+
+  // strings must fit into their field including the terminating zero
+  {
+    test::Config config = defaults();
+    CHECK(read("{\"ssid\":\"1234567\"}", config));
+    CHECK(strcmp(config.ssid, "1234567") == 0);
+    CHECK(!read("{\"ssid\":\"12345678\"}", config));
+    CHECK(!read("{\"ssid\":\"a string longer than the buffer of the reader\"}", config));
+  }
+
+  // values of another type or out of the range of the field fail
+  {
+    test::Config config = defaults();
+    CHECK(!read("{\"interval\":\"10\"}", config));
+    CHECK(!read("{\"byte\":256}", config));
+    CHECK(!read("{\"byte\":-1}", config));
+    CHECK(!read("{\"largest\":18446744073709551616}", config));
+    CHECK(!read("{\"levels\":[1,2,3,4]}", config));
+  }
+
+  // writing and reading the same values again, including the edges of the integer types
+  {
+    test::Config config = defaults();
+    config.interval = INT32_MIN;
+    strcpy(config.ssid, "a\"b\\c");
+    config.sensors[0].id = INT32_MAX;
+    strcpy(config.sensors[0].name, "x");
+    config.levels[0] = INT16_MIN;
+    config.levels[2] = INT16_MAX;
+    config.enabled = true;
+    config.ratio = -1.5;
+    config.smallest = INT64_MIN;
+    config.largest = UINT64_MAX;
+    config.byte = 255u;
+
+    const std::string written = write(config);
+    CHECK(written == "{\"interval\":-2147483648,\"ssid\":\"a\\\"b\\\\c\",\"sensors\":[{\"id\":2147483647,\"name\":\"x\"},{\"id\":0,\"name\":\"\"}],"
+      "\"levels\":[-32768,0,32767],\"enabled\":true,\"ratio\":-1.5,\"smallest\":-9223372036854775808,\"largest\":18446744073709551615,\"byte\":255}");
+
+    test::Config copy {};
+    CHECK(read(written, copy));
+    CHECK(write(copy) == written);
+    CHECK(copy.largest == UINT64_MAX);
+    CHECK(copy.smallest == INT64_MIN);
+  }
+
+  return TEST_RESULT();
+}
@@ -0,0 +1,40 @@
+#include "Test.h"
+
+template<size_t max_token_length = 64u>
+static bool valid(const char* document) {
+  toolbox::StringInput input {document};
+  return !jsons::validate<max_token_length>(input).failed();
+}
+
+static std::string errorOf(const char* document) {
+  toolbox::StringInput input {document};
+  return jsons::validate(input).diagnostics().errorMessage.toString();
+}
+
+int main() {
+  CHECK(valid("{\"a\":[0,-0,1.5e3,-0.25,10],\"b\":\"x\\n\\u00e4\\\"\",\"c\":[true,false,null]}"));
+  CHECK(valid("\"tab\\tand\\u0001\""));
+  CHECK(valid<8u>("[\"a string longer than the buffer\\n with escapes\\u00e4\"]"));
+
+  // leading zeros
+  CHECK(!valid("01"));
+  CHECK(!valid("-01"));
+  CHECK(!valid("-0001"));
+  CHECK(!valid("[1,00]"));
+  CHECK(!valid("{\"a\":01.5}"));
+
+  // unescaped control characters in strings
+  CHECK(!valid("\"a\x01b\""));
+  CHECK(!valid("\"tab\tinside\""));
+  CHECK(!valid("[\"line\nbreak\"]"));
+  CHECK(!valid("{\"na\x1fme\":1}"));
+  CHECK(!valid<8u>("[\"a string longer than the buffer\x02\"]"));
+  CHECK(errorOf("\"a\x01\"") == "Unescaped control character in string.");
+
+  // invalid escape sequences
+  CHECK(!valid("\"\\x\""));
+  CHECK(!valid("\"\\u12\""));
+  CHECK(errorOf("\"\\a\"") == "Invalid escape sequence in string.");
+
+  return TEST_RESULT();
+}
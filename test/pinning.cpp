@@ -0,0 +1,115 @@
+#include "Test.h"
+
+/**
+ * Dumps the value, where the name of a property is also dumped after its
+ * value to check that it is still the same.
+ */
+static void dump(jsons::Value& value, std::string& dumped) {
+  switch (value.type()) {
+    case jsons::ValueType::String:
+      if (value.isLongString()) {
+        dumped += "long:";
+        for (auto& fragment : value.asStringFragments()) {
+          dumped += fragment.toString();
+        }
+      } else {
+        dumped += "\"" + value.asString().get().toString() + "\"";
+      }
+      break;
+    case jsons::ValueType::Integer:
+      dumped += std::to_string(value.asInteger().get());
+      break;
+    case jsons::ValueType::List:
+      dumped += "[";
+      for (auto& element : value.asList()) {
+        dump(element, dumped);
+        dumped += ",";
+      }
+      dumped += "]";
+      break;
+    case jsons::ValueType::Object:
+      dumped += "{";
+      for (auto& property : value.asObject()) {
+        const toolbox::strref name = property.name();
+        dumped += name.toString() + ":";
+        dump(property, dumped);
+        dumped += "/" + name.toString() + ",";
+      }
+      dumped += "}";
+      break;
+    default:
+      dumped += "?";
+      break;
+  }
+}
+
+template<typename Reader>
+static std::string read(const char* document, size_t chunk) {
+  toolbox::StringInput input {document, chunk};
+  Reader reader {input};
+  std::string dumped;
+  {
+    auto root = reader.begin();
+    dump(root, dumped);
+  }
+  reader.end();
+  return reader.failed() ? "failed: " + reader.diagnostics().errorMessage.toString() : dumped;
+}
+
+template<size_t max_token_length>
+static bool sameAsReader(const char* document) {
+  bool same = true;
+  for (size_t chunk : {size_t(1u), size_t(7u), SIZE_MAX}) {
+    const std::string expected = read<jsons::Reader<toolbox::IInput, max_token_length>>(document, chunk);
+    const std::string actual = read<jsons::PinningReader<toolbox::IInput, max_token_length>>(document, chunk);
+    if (actual != expected) {
+      printf("chunk %zu: expected %s, but got %s\n", chunk, expected.c_str(), actual.c_str());
+      same = false;
+    }
+  }
+  return same;
+}
+
+using Reader16 = jsons::Reader<toolbox::IInput, 16u>;
+using PinningReader16 = jsons::PinningReader<toolbox::IInput, 16u>;
+
+static const char* const LONG_LIST = "{\"name1\":[\"aaaaaaaaaaaaaa\",\"bbbbbbbbbbbbbbbbb\",\"cc\",1,\"dddddddddddddd\",\"eeeeeeeeeeeeeeeee\",\"ffffffffffffff\",\"ggggggggggggggggg\"],\"name2\":\"x\"}";
+
+int main() {
+  // the name of a property stays the same while its value is read, even if the buffer is refilled
+  {
+    toolbox::StringInput input {LONG_LIST};
+    jsons::PinningReader<toolbox::IInput, 32u> reader {input};
+    {
+      auto root = reader.begin();
+      for (auto& property : root.asObject()) {
+        const toolbox::strref name = property.name();
+        const std::string copied = name.toString();
+        if (property.type() == jsons::ValueType::List) {
+          size_t elements = 0;
+          for (auto& element : property.asList()) {
+            CHECK(element.valid());
+            ++elements;
+          }
+          CHECK(elements == 8u);
+        }
+        CHECK(name.toString() == copied);
+        CHECK(property.name().toString() == copied);
+      }
+    }
+    reader.end();
+    CHECK(!reader.failed());
+  }
+
+  CHECK(sameAsReader<32u>(LONG_LIST));
+  CHECK(sameAsReader<16u>("{\"a\":{\"b\":[\"0123456789\",\"x\\\"y\\\\z\"],\"c\":{}},\"d\":[[\"e\"],{\"f\":\"g\"}]}"));
+  CHECK(sameAsReader<16u>("[\"a string longer than the buffer\",{\"n\":\"another string longer than the buffer\"}]"));
+  CHECK(sameAsReader<64u>("{\"config\":{\"interval\":30,\"name\":\"sensor \\u00e4\"},\"values\":[1,2,3,\"four\"]}"));
+
+  // a name which only does not fit because of the pinned name of the outer property
+  // (which is replaced by the inner name, like the stored name of Reader)
+  CHECK(read<Reader16>("{\"abcdefghij\":{\"klmnopq\":1}}", SIZE_MAX) == "{abcdefghij:{klmnopq:1/klmnopq,}/klmnopq,}");
+  CHECK(read<PinningReader16>("{\"abcdefghij\":{\"klmnopq\":1}}", SIZE_MAX) == "failed: Pinned tokens exhaust the buffer.");
+
+  return TEST_RESULT();
+}
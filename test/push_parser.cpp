@@ -0,0 +1,140 @@
+#include "Test.h"
+#include <vector>
+
+/**
+ * Records the events as text, where the fragments of a string are joined
+ * (as they depend on where the input is split).
+ */
+struct Recorder : jsons::EventHandler {
+  std::string events;
+  std::string fragments;
+
+  void onNull() { events += "null,"; }
+  void onBoolean(bool value) { events += value ? "true," : "false,"; }
+  void onNumber(const jsons::Number& number) { events += std::string("n:") + number.literal() + ","; }
+  void onStringFragment(const toolbox::strref& fragment) { fragments += fragment.toString(); }
+  void onString(const toolbox::strref& string) {
+    events += "s:" + fragments + string.toString() + ",";
+    fragments.clear();
+  }
+  void onKey(const toolbox::strref& key) { events += "k:" + key.toString() + ","; }
+  void onOpenList() { events += "[,"; }
+  void onCloseList() { events += "],"; }
+  void onOpenObject() { events += "{,"; }
+  void onCloseObject() { events += "},"; }
+};
+
+using PushParser16 = jsons::PushParser<Recorder, 16u>;
+
+static std::string parseWhole(const std::string& document) {
+  toolbox::StringInput input {document.c_str()};
+  Recorder recorder;
+  auto parser = jsons::parse<16u>(input, recorder);
+  return parser.failed() ? "failed" : recorder.events;
+}
+
+/** Feeds the document in the given chunks, returns the events or "failed". */
+static std::string push(const std::string& document, const std::vector<size_t>& chunks) {
+  Recorder recorder;
+  PushParser16 parser {recorder};
+  size_t position = 0u;
+  for (size_t chunk : chunks) {
+    if (parser.feed(document.c_str() + position, chunk) == jsons::ParseStatus::Failed) {
+      return "failed";
+    }
+    position += chunk;
+  }
+  return parser.finish() == jsons::ParseStatus::Done ? recorder.events : "failed";
+}
+
+/** Checks the events against parse() at every split point and chunk size. */
+static bool sameAsParse(const std::string& document) {
+  const std::string expected = parseWhole(document);
+  if (expected == "failed") {
+    printf("%s: parse() failed\n", document.c_str());
+    return false;
+  }
+  bool same = true;
+  const size_t length = document.size();
+  for (size_t split = 0u; split <= length; ++split) {
+    const std::string actual = push(document, {split, length - split});
+    if (actual != expected) {
+      printf("%s: split at %zu: expected %s, but got %s\n", document.c_str(), split, expected.c_str(), actual.c_str());
+      same = false;
+    }
+  }
+  for (size_t chunk = 1u; chunk <= length; ++chunk) {
+    std::vector<size_t> chunks(length / chunk, chunk);
+    if (length % chunk != 0u) {
+      chunks.push_back(length % chunk);
+    }
+    const std::string actual = push(document, chunks);
+    if (actual != expected) {
+      printf("%s: chunks of %zu: expected %s, but got %s\n", document.c_str(), chunk, expected.c_str(), actual.c_str());
+      same = false;
+    }
+  }
+  return same;
+}
+
+/** Checks that every proper prefix of the document needs more data and fails when finished. */
+static bool needsMoreData(const std::string& document) {
+  bool needs = true;
+  for (size_t length = 0u; length < document.size(); ++length) {
+    Recorder recorder;
+    PushParser16 parser {recorder};
+    if (parser.feed(document.c_str(), length) != jsons::ParseStatus::NeedMoreData) {
+      printf("%s: truncated to %zu does not need more data\n", document.c_str(), length);
+      needs = false;
+    } else if (parser.finish() != jsons::ParseStatus::Failed) {
+      printf("%s: truncated to %zu does not fail when finished\n", document.c_str(), length);
+      needs = false;
+    }
+  }
+  return needs;
+}
+
+static jsons::ParseStatus feedAll(const char* document) {
+  Recorder recorder;
+  PushParser16 parser {recorder};
+  const jsons::ParseStatus status = parser.feed(document, strlen(document));
+  return status == jsons::ParseStatus::Failed ? status : parser.finish();
+}
+
+int main() {
+  CHECK(sameAsParse("{\"a\":[0,-0,1.5e3,-0.25,10],\"b\":\"x\\n\\u00e4\\\"\",\"c\":[true,false,null]}"));
+  CHECK(sameAsParse(" [ {\"name\" : \"a string longer than the buffer\"} , [ [ ] , { } ] , 12345678901234 ] "));
+  CHECK(sameAsParse("{\"key\":\"\",\"list\":[\"\",\"0123456789abcdef\",null]}"));
+  CHECK(sameAsParse("\"a root string which is longer than the buffer\""));
+  CHECK(sameAsParse("-12.5e-3"));
+  CHECK(sameAsParse("true"));
+
+  CHECK(needsMoreData("{\"a\":[1,true,null],\"b\":\"text\"}"));
+  CHECK(needsMoreData("[[],{}]"));
+
+  // a number at the end of the input only ends with finish()
+  {
+    Recorder recorder;
+    PushParser16 parser {recorder};
+    CHECK(parser.feed("42", 2u) == jsons::ParseStatus::NeedMoreData);
+    CHECK(recorder.events.empty());
+    CHECK(parser.finish() == jsons::ParseStatus::Done);
+    CHECK(recorder.events == "n:42,");
+  }
+
+  // trailing garbage, also when it arrives in a later chunk
+  CHECK(feedAll("{} x") == jsons::ParseStatus::Failed);
+  CHECK(feedAll("[1]]") == jsons::ParseStatus::Failed);
+  CHECK(feedAll("true false") == jsons::ParseStatus::Failed);
+  CHECK(feedAll("{}\n") == jsons::ParseStatus::Done);
+  {
+    Recorder recorder;
+    PushParser16 parser {recorder};
+    CHECK(parser.feed("{\"a\":1}", 7u) == jsons::ParseStatus::Done);
+    CHECK(parser.feed(" ", 1u) == jsons::ParseStatus::Done);
+    CHECK(parser.feed("x", 1u) == jsons::ParseStatus::Failed);
+    CHECK(parser.finish() == jsons::ParseStatus::Failed);
+  }
+
+  return TEST_RESULT();
+}
@@ -0,0 +1,298 @@
+#include <vector>
+#include "Test.h"
+
+/** Reads the document completely, returns false if reading failed. */
+static bool readNumbers(const char* document) {
+  toolbox::StringInput input {document};
+  auto reader = jsons::makeReader(input);
+  {
+    auto root = reader.begin();
+    if (root.type() == jsons::ValueType::List) {
+      for (auto& element : root.asList()) {
+        element.asDouble();
+      }
+    } else {
+      root.asDouble();
+    }
+  }
+  reader.end();
+  return !reader.failed();
+}
+
+static jsons::ValueType typeOf(const char* literal) {
+  toolbox::StringInput input {literal};
+  auto reader = jsons::makeReader(input);
+  auto root = reader.begin();
+  return root.type();
+}
+
+/** Reads the string, returns "failed" if reading failed. */
+static std::string stringOf(const char* document) {
+  toolbox::StringInput input {document};
+  auto reader = jsons::makeReader(input);
+  std::string string;
+  {
+    auto root = reader.begin();
+    auto value = root.asString();
+    string = value ? value.get().toString() : "not a string";
+  }
+  reader.end();
+  return reader.failed() ? "failed" : string;
+}
+
+static constexpr const char* KEYS[] = {"a", "b", "d"};
+static_assert(jsons::keysSorted(KEYS), "KEYS must be sorted");
+
+static constexpr const char* UNSORTED_KEYS[] = {"a", "d", "b"};
+static_assert(!jsons::keysSorted(UNSORTED_KEYS), "UNSORTED_KEYS must not be sorted");
+static constexpr const char* DUPLICATE_KEYS[] = {"a", "a"};
+static_assert(!jsons::keysSorted(DUPLICATE_KEYS), "DUPLICATE_KEYS must not be sorted");
+
+/** Reads the object with KEYS, returns the keys and values of the properties read. */
+static std::string readKeys(const char* document) {
+  toolbox::StringInput input {document};
+  auto reader = jsons::makeReader(input);
+  std::string read;
+  {
+    auto root = reader.begin();
+    for (auto& property : root.asObject(KEYS)) {
+      read += std::to_string(property.key()) + property.name().toString() + "=" + std::to_string(property.asInteger().get()) + ";";
+    }
+  }
+  reader.end();
+  return reader.failed() ? "failed" : read;
+}
+
+/** Reads the object in place with a SpanReader, like readKeys() but by names. */
+static std::string readInPlace(std::string document) {
+  auto reader = jsons::makeReader(&document[0], document.size());
+  std::string read;
+  {
+    auto root = reader.begin();
+    for (auto& property : root.asObject()) {
+      read += property.name().toString() + "=";
+      if (property.type() == jsons::ValueType::String) {
+        read += property.asString().get().toString();
+      } else {
+        read += property.asNumber().literal();
+      }
+      read += "/" + property.name().toString() + ";";
+    }
+  }
+  reader.end();
+  return reader.failed() ? reader.diagnostics().errorMessage.toString() : read;
+}
+
+static void dump(jsons::Value& value, std::string& dumped) {
+  switch (value.type()) {
+    case jsons::ValueType::Null:
+      dumped += "null";
+      break;
+    case jsons::ValueType::Boolean:
+      dumped += value.asBoolean().get() ? "true" : "false";
+      break;
+    case jsons::ValueType::Integer:
+    case jsons::ValueType::Decimal:
+      dumped += value.asNumber().literal();
+      break;
+    case jsons::ValueType::String:
+      dumped += "\"" + value.asString().get().toString() + "\"";
+      break;
+    case jsons::ValueType::List:
+      dumped += "[";
+      for (auto& element : value.asList()) {
+        dump(element, dumped);
+        dumped += ",";
+      }
+      dumped += "]";
+      break;
+    case jsons::ValueType::Object:
+      dumped += "{";
+      for (auto& property : value.asObject()) {
+        dumped += property.name().toString() + ":";
+        dump(property, dumped);
+        dumped += ",";
+      }
+      dumped += "}";
+      break;
+    default:
+      dumped += "?";
+      break;
+  }
+}
+
+/**
+ * Reads all documents of the input with nextDocument(), where the input
+ * provides at most chunk characters at once.
+ */
+static std::string readDocuments(const char* input, size_t chunk = SIZE_MAX) {
+  toolbox::StringInput stream {input, chunk};
+  jsons::Reader<toolbox::IInput, 16u> reader {stream};
+  std::string read;
+  while (reader.nextDocument()) {
+    {
+      auto root = reader.begin();
+      dump(root, read);
+    }
+    read += ";";
+  }
+  return reader.failed() ? read + "failed: " + reader.diagnostics().errorMessage.toString() : read;
+}
+
+using Fragments = std::vector<std::string>;
+
+/** Reads the string in fragments with a buffer of 16 characters. */
+static Fragments fragmentsOf(const std::string& document) {
+  toolbox::StringInput input {document.c_str()};
+  jsons::Reader<toolbox::IInput, 16u> reader {input};
+  Fragments fragments;
+  {
+    auto root = reader.begin();
+    for (auto& fragment : root.asStringFragments()) {
+      fragments.push_back(fragment.toString());
+    }
+  }
+  reader.end();
+  return reader.failed() ? Fragments {"failed"} : fragments;
+}
+
+static std::string joined(const Fragments& fragments) {
+  std::string joined;
+  for (auto& fragment : fragments) {
+    CHECK(!fragment.empty());
+    joined += fragment;
+  }
+  return joined;
+}
+
+/**
+ * Checks that the escape sequence is decoded if the string is read in
+ * fragments, at each position relative to the boundaries of the fragments.
+ */
+static bool decodedAcrossFragments(const char* escape, const char* decoded) {
+  bool ok = true;
+  for (size_t prefix = 0; prefix < 20; ++prefix) {
+    const std::string padding = std::string(prefix, 'a');
+    const std::string document = "\"" + padding + escape + "0123456789012345\"";
+    if (joined(fragmentsOf(document)) != padding + decoded + "0123456789012345") {
+      printf("escape %s after %zu characters not decoded\n", escape, prefix);
+      ok = false;
+    }
+  }
+  return ok;
+}
+
+int main() {
+  CHECK(typeOf("0") == jsons::ValueType::Integer);
+  CHECK(typeOf("-0") == jsons::ValueType::Integer);
+  CHECK(typeOf("10") == jsons::ValueType::Integer);
+  CHECK(typeOf("0.5") == jsons::ValueType::Decimal);
+  CHECK(typeOf("-0e1") == jsons::ValueType::Decimal);
+  CHECK(typeOf("1E+2") == jsons::ValueType::Decimal);
+
+  // leading zeros are not allowed in the integer part
+  CHECK(typeOf("01") == jsons::ValueType::Invalid);
+  CHECK(typeOf("-01") == jsons::ValueType::Invalid);
+  CHECK(typeOf("00") == jsons::ValueType::Invalid);
+  CHECK(typeOf("00.5") == jsons::ValueType::Invalid);
+
+  CHECK(readNumbers("[0, -0, 0.001, 100, 1.5e-3, 0E0]"));
+  CHECK(!readNumbers("01"));
+  CHECK(!readNumbers("-01"));
+  CHECK(!readNumbers("00"));
+  CHECK(!readNumbers("[1, 01]"));
+
+  // other invalid numbers
+  CHECK(!readNumbers("-"));
+  CHECK(!readNumbers("1."));
+  CHECK(!readNumbers(".5"));
+  CHECK(!readNumbers("1e"));
+  CHECK(!readNumbers("+1"));
+
+  // properties are dispatched by their key, properties with unknown names are skipped
+  CHECK(readKeys("{\"b\":1,\"x\":{\"a\":2},\"a\":3,\"c\":[\"d\"],\"bb\":5,\"d\":4}") == "1b=1;0a=3;2d=4;");
+  CHECK(readKeys("{\"x\":1,\"y\":2}") == "");
+  CHECK(readKeys("{}") == "");
+
+  // stored strings of a SpanReader are terminated in the document
+  CHECK(readInPlace("{\"a\":\"x\\\"y\",\"bc\" : 12 ,\"d\":\"\"}") == "a=x\"y/a;bc=12/bc;d=/d;");
+  // as are numbers, which are not limited in length
+  CHECK(readInPlace("{\"a\":1234567890123456789012345,\"b\":-1.25e-300}") == "a=1234567890123456789012345/a;b=-1.25e-300/b;");
+  CHECK(readInPlace("{\"a\":1,\"b\":2 , \"c\":3\n}") == "a=1/a;b=2/b;c=3/c;");
+  {
+    char document[] = "[1,-22,[333],4.5e6]";
+    auto reader = jsons::makeReader(document, sizeof(document) - 1u);
+    std::string read;
+    {
+      auto root = reader.begin();
+      for (auto& element : root.asList()) {
+        if (element.type() == jsons::ValueType::List) {
+          for (auto& inner : element.asList()) {
+            read += std::string("[") + inner.asNumber().literal() + "]";
+          }
+        } else {
+          read += std::string(element.asNumber().literal()) + ";";
+        }
+      }
+    }
+    reader.end();
+    CHECK(!reader.failed());
+    CHECK(read == "1;-22;[333]4.5e6;");
+  }
+  {
+    char document[] = "12x";
+    auto reader = jsons::makeReader(document, sizeof(document) - 1u);
+    CHECK(reader.begin().asInteger().get() == 12);
+    reader.end();
+    CHECK(reader.failed());
+  }
+
+  // several documents one after another, with or without whitespace in between
+  {
+    const char* const documents = "{\"a\":[1,2],\"b\":\"x\"}\n[true,null]  \r\n\t\"s\" 12\n-3.5{}[]\n";
+    const std::string expected = "{a:[1,2,],b:\"x\",};[true,null,];\"s\";12;-3.5;{};[];";
+    CHECK(readDocuments(documents) == expected);
+    for (size_t chunk = 1u; chunk <= strlen(documents); ++chunk) {
+      CHECK(readDocuments(documents, chunk) == expected);
+    }
+  }
+  // a document which ends exactly at the end of a chunk of the input
+  CHECK(readDocuments("[1,2][3]", 5u) == "[1,2,];[3,];");
+  CHECK(readDocuments("{\"a\":1}\n{\"b\":2}\n", 8u) == "{a:1,};{b:2,};");
+  // nothing (or only whitespace) after the last document, or no document at all
+  CHECK(readDocuments("[1]\n \n") == "[1,];");
+  CHECK(readDocuments("  \n") == "");
+  CHECK(readDocuments("") == "");
+  // a failure in the second document ends reading, after the first one
+  CHECK(readDocuments("[1]\n[2,x]\n[3]") == "[1,];[2,];failed: Unexpected character at start of value.");
+  CHECK(readDocuments("{\"a\":1}\n{\"b\" 2}\n{}", 4u) == "{a:1,};{};failed: Expected ':' after property name.");
+
+  // \uXXXX escape sequences are decoded to UTF-8
+  CHECK(stringOf("\"\\u0041\\u00e4\\u00C4\"") == "A\xc3\xa4\xc3\x84");
+  CHECK(stringOf("\"\\u20ac \\uffff\"") == "\xe2\x82\xac \xef\xbf\xbf");
+  CHECK(stringOf("\"\\ud83d\\ude00\\uD834\\uDD1E\"") == "\xf0\x9f\x98\x80\xf0\x9d\x84\x9e");
+
+  // lone surrogates are replaced by U+FFFD
+  CHECK(stringOf("\"\\ud83d\"") == "\xef\xbf\xbd");
+  CHECK(stringOf("\"\\ud83dx\"") == "\xef\xbf\xbdx");
+  CHECK(stringOf("\"\\ud83d\\u0041\"") == "\xef\xbf\xbd" "A");
+  CHECK(stringOf("\"\\ude00\\ud83d\"") == "\xef\xbf\xbd\xef\xbf\xbd");
+
+  // invalid and truncated sequences (and \u0000) are kept as they are
+  CHECK(stringOf("\"\\u12\"") == "\\u12");
+  CHECK(stringOf("\"\\u12G4\"") == "\\u12G4");
+  CHECK(stringOf("\"\\u\"") == "\\u");
+  CHECK(stringOf("\"\\u0000\"") == "\\u0000");
+  CHECK(stringOf("\"\\ud83d\\ude\"") == "\xef\xbf\xbd\\ude");
+
+  // strings longer than the buffer are read in fragments, without an empty last fragment
+  CHECK(fragmentsOf("\"abcdefghijklmnopqrstuvwxyzABCDEF\"") == (Fragments {"abcdefghijklmnop", "qrstuvwxyzABCDEF"}));
+  CHECK(joined(fragmentsOf("\"abcdefghijklmnopqrstuvwxyz\"")) == "abcdefghijklmnopqrstuvwxyz");
+  CHECK(decodedAcrossFragments("\\\"", "\""));
+  CHECK(decodedAcrossFragments("\\\\", "\\"));
+  CHECK(decodedAcrossFragments("\\n", "\n"));
+  CHECK(decodedAcrossFragments("\\u00e4", "\xc3\xa4"));
+  CHECK(decodedAcrossFragments("\\ud83d\\ude00", "\xf0\x9f\x98\x80"));
+
+  return TEST_RESULT();
+}
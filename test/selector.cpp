@@ -0,0 +1,38 @@
+#include "Test.h"
+
+static const char* const PATHS[] = {"/a", "/x", "/config/interval", "/sensors/*/id", ""};
+
+static std::string select(const char* document, bool readObjects) {
+  toolbox::StringInput input {document};
+  auto reader = jsons::makeReader(input);
+  auto selector = jsons::makeSelector(PATHS);
+  std::string selected;
+  auto handler = [&](size_t path, jsons::Value& value) {
+    selected += std::to_string(path) + ":";
+    if (value.type() == jsons::ValueType::Integer) {
+      selected += std::to_string(value.asInteger().get());
+    } else if (value.type() == jsons::ValueType::Object && readObjects && path != 4) {
+      for (auto& property : value.asObject()) {
+        selected += property.name().toString();
+      }
+    }
+    selected += ";";
+  };
+  {
+    auto root = reader.begin();
+    selector.select(root, handler);
+  }
+  reader.end();
+  return reader.failed() ? "failed" : selected;
+}
+
+int main() {
+  CHECK(select("{\"config\":{\"x\":1,\"interval\":30},\"sensors\":[{\"id\":1},{\"name\":\"b\",\"id\":2}]}", false) == "4:;2:30;3:1;3:2;");
+
+  // reading a selected object replaces the stored name of its property,
+  // which must not be matched against the remaining paths afterwards
+  CHECK(select("{\"a\":{\"x\":1},\"b\":2}", true) == "4:;0:x;");
+  CHECK(select("{\"a\":{\"x\":1},\"x\":2}", true) == "4:;0:x;1:2;");
+
+  return TEST_RESULT();
+}
@@ -0,0 +1,64 @@
+#include <vector>
+#include "Test.h"
+
+using jsons::RecordFormat;
+
+/** Splits the document, returns the records or "failed" as the only one. */
+static std::vector<std::string> split(std::string document, RecordFormat format) {
+  std::vector<std::string> records;
+  jsons::RecordSplitter splitter {&document[0], document.size(), format};
+  while (auto record = splitter.next()) {
+    CHECK(record.get().sequence == records.size());
+    CHECK(strlen(record.get().document) == record.get().length);
+    records.push_back(record.get().document);
+  }
+  if (splitter.failed()) {
+    return {"failed"};
+  }
+  return records;
+}
+
+using Records = std::vector<std::string>;
+
+int main() {
+  CHECK(split("{\"a\":1}\n\n  \n[1,2]\r\n\"x\\ny\"\n3", RecordFormat::Lines) == (Records {"{\"a\":1}", "[1,2]\r", "\"x\\ny\"", "3"}));
+  CHECK(split("", RecordFormat::Lines).empty());
+
+  CHECK(split(" [ ] ", RecordFormat::ListElements).empty());
+  CHECK(split("[1]", RecordFormat::ListElements) == (Records {"1"}));
+  CHECK(split(" [ {\"a,]\":[1,{\"b\":\"\\\"]\"}]} , \"s,\\\\\" ,null,[[]],-1.5e3 ]\n", RecordFormat::ListElements)
+    == (Records {" {\"a,]\":[1,{\"b\":\"\\\"]\"}]} ", " \"s,\\\\\" ", "null", "[[]]", "-1.5e3 "}));
+
+  // empty elements
+  CHECK(split("[1,]", RecordFormat::ListElements) == (Records {"failed"}));
+  CHECK(split("[,1]", RecordFormat::ListElements) == (Records {"failed"}));
+  CHECK(split("[1, ,2]", RecordFormat::ListElements) == (Records {"failed"}));
+  CHECK(split("[,]", RecordFormat::ListElements) == (Records {"failed"}));
+
+  // malformed lists
+  CHECK(split("{}", RecordFormat::ListElements) == (Records {"failed"}));
+  CHECK(split("[1,2", RecordFormat::ListElements) == (Records {"failed"}));
+  CHECK(split("[\"abc", RecordFormat::ListElements) == (Records {"failed"}));
+  CHECK(split("[1,2]x", RecordFormat::ListElements) == (Records {"failed"}));
+  CHECK(split("[1}", RecordFormat::ListElements) == (Records {"failed"}));
+
+  // each record is a document of its own
+  std::string document = "[{\"id\":0},{\"id\":1,\"s\":\"a,]\"},{\"id\":2,\"l\":[1,[2]]}]";
+  jsons::RecordSplitter splitter {&document[0], document.size(), RecordFormat::ListElements};
+  while (auto record = splitter.next()) {
+    auto reader = jsons::makeReader(record.get().document, record.get().length);
+    {
+      auto root = reader.begin();
+      for (auto& property : root.asObject()) {
+        if (property.name() == "id") {
+          CHECK(property.asInteger().get() == static_cast<int32_t>(record.get().sequence));
+        }
+      }
+    }
+    reader.end();
+    CHECK(!reader.failed());
+  }
+  CHECK(!splitter.failed() && splitter.count() == 3u);
+
+  return TEST_RESULT();
+}
@@ -0,0 +1,5 @@
+#pragma once
+#include "toolbox/String.h"
+#include "toolbox/Maybe.h"
+#include "toolbox/Decimal.h"
+#include "toolbox/Streams.h"
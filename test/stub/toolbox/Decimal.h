@@ -0,0 +1,25 @@
+#pragma once
+#include "String.h"
+#include "Maybe.h"
+#include <cstdlib>
+#include <cstdio>
+namespace toolbox {
+class Decimal {
+  int32_t _v = 0; uint8_t _d = 0;
+public:
+  struct Str { char b[24]; operator strref() const { return strref(b); } String toString() const { return String(b); } };
+  Decimal() {}
+  static Decimal fromFixedPoint(int32_t v, uint8_t d) { Decimal x; x._v = v; x._d = d; return x; }
+  static Maybe<Decimal> fromString(const strref& s) {
+    const char* p = s.cstr(); char* e; double d = strtod(p, &e);
+    if (e == p || *e) return {};
+    const char* dot = strchr(p, '.'); uint8_t n = dot ? strlen(dot + 1) : 0;
+    double m = d; for (uint8_t i = 0; i < n; ++i) m *= 10;
+    return Maybe<Decimal>(fromFixedPoint((int32_t)(m + (m < 0 ? -0.5 : 0.5)), n));
+  }
+  bool isInteger() const { return _d == 0; }
+  int32_t integer() const { int32_t v = _v; for (uint8_t i = 0; i < _d; ++i) v /= 10; return v; }
+  // an int32_t has at most 9 digits after the point (which also keeps snprintf from warning)
+  Str toString() const { Str s; if (_d == 0) snprintf(s.b, 24, "%d", _v); else { int32_t p = 1; for (int i=0;i<_d;++i) p*=10; snprintf(s.b, 24, "%s%d.%0*d", (_v<0&&_v/p==0)?"-":"", _v / p, _d < 10 ? int(_d) : 9, abs(_v % p)); } return s; }
+};
+}
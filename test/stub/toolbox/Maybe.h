@@ -0,0 +1,12 @@
+#pragma once
+#include <type_traits>
+namespace toolbox {
+template<typename T> class Maybe {
+  bool _has = false; std::remove_reference_t<T> _v{};
+public:
+  Maybe() {}
+  Maybe(const std::remove_reference_t<T>& v) : _has(true), _v(v) {}
+  explicit operator bool() const { return _has; }
+  const std::remove_reference_t<T>& get() const { return _v; }
+};
+}
@@ -0,0 +1,20 @@
+#pragma once
+#include "String.h"
+namespace toolbox {
+class IInput { public: virtual size_t available() const = 0; virtual char read() = 0; virtual size_t readString(char* b, size_t n) = 0; };
+class IOutput { public: virtual size_t write(char c) = 0; virtual size_t write(const strref& s) = 0; };
+class StringInput final : public IInput {
+  strref _s; size_t _pos = 0, _len; size_t _chunk;
+public:
+  StringInput(const strref& s, size_t chunk = SIZE_MAX) : _s(s), _len(s.length()), _chunk(chunk) {}
+  size_t available() const override { return _len - _pos; }
+  char read() override { return _pos < _len ? _s.charAt(_pos++) : '\0'; }
+  size_t readString(char* b, size_t n) override { size_t k = 0; while (k < n && k < _chunk && _pos < _len) b[k++] = _s.charAt(_pos++); return k; }
+};
+class StringOutput final : public IOutput {
+public:
+  std::string out; size_t calls = 0; size_t limit = SIZE_MAX;
+  size_t write(char c) override { ++calls; if (out.size() >= limit) return 0; out += c; return 1; }
+  size_t write(const strref& s) override { ++calls; size_t n = 0; for (size_t i = 0; i < s.length(); ++i) { if (out.size() >= limit) break; out += s.charAt(i); ++n; } return n; }
+};
+}
@@ -0,0 +1,31 @@
+#pragma once
+#include <cstring>
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <functional>
+#include <utility>
+#include <iterator>
+class __FlashStringHelper;
+#define F(s) (reinterpret_cast<const __FlashStringHelper*>(s))
+#define PROGMEM
+using String = std::string;
+namespace toolbox {
+class strref {
+  const char* _s = nullptr; bool _p = false;
+public:
+  strref() {}
+  strref(const char* s) : _s(s) {}
+  strref(const __FlashStringHelper* s) : _s(reinterpret_cast<const char*>(s)), _p(true) {}
+  strref(const String& s) : _s(s.c_str()) {}
+  size_t length() const { return _s ? strlen(_s) : 0; }
+  char charAt(size_t i) const { return _s[i]; }
+  const char* cstr() const { return _s ? _s : ""; }
+  const __FlashStringHelper* fpstr() const { return reinterpret_cast<const __FlashStringHelper*>(_s); }
+  bool isInProgmem() const { return _p; }
+  bool empty() const { return length() == 0; }
+  String toString() const { return String(cstr()); }
+  bool operator==(const strref& o) const { return strcmp(cstr(), o.cstr()) == 0; }
+  bool operator!=(const strref& o) const { return !(*this == o); }
+};
+}
@@ -0,0 +1,169 @@
+#include <climits>
+#include "Test.h"
+
+template<typename Write>
+static std::string write(Write write, bool* failed = nullptr) {
+  toolbox::StringOutput output;
+  auto writer = jsons::makeWriter(output);
+  write(writer);
+  writer.end();
+  if (failed) {
+    *failed = writer.failed();
+  }
+  return output.out;
+}
+
+/**
+ * Writes the same with a SizeCounter as with an output, and checks that
+ * it counts exactly the characters written to the output (also if writing
+ * fails).
+ */
+template<size_t buffer_size = 0u, size_t max_depth = 20u, typename Write>
+static bool countsSize(Write write) {
+  toolbox::StringOutput output;
+  jsons::Writer<toolbox::StringOutput, buffer_size, max_depth> writer {output};
+  write(writer);
+  writer.end();
+  jsons::SizeCounter counter;
+  jsons::Writer<jsons::SizeCounter, buffer_size, max_depth> counting {counter};
+  write(counting);
+  counting.end();
+  if (counter.size() != output.out.size() || counting.failed() != writer.failed()) {
+    printf("counted %zu (failed %d), but wrote %zu (failed %d): %s\n", counter.size(), counting.failed(), output.out.size(), writer.failed(), output.out.c_str());
+    return false;
+  }
+  return true;
+}
+
+/**
+ * Implementation of IWriter which only implements the methods without a
+ * default implementation (and fail(), to see the failures of the default
+ * implementations), by forwarding them to a Writer.
+ */
+class ForwardingWriter : public jsons::IWriter {
+protected:
+  jsons::IWriter& _writer;
+
+public:
+  ForwardingWriter(jsons::IWriter& writer) : _writer(writer) {}
+
+  void null() override { _writer.null(); }
+  void boolean(const toolbox::Maybe<bool>& value) override { _writer.boolean(value); }
+  void number(const toolbox::Maybe<int32_t>& value) override { _writer.number(value); }
+  void number(const toolbox::Maybe<const toolbox::Decimal&>& value) override { _writer.number(value); }
+  void string(const toolbox::Maybe<const char*>& value) override { _writer.string(value); }
+  void string(const toolbox::Maybe<const __FlashStringHelper*>& value) override { _writer.string(value); }
+  void string(const toolbox::Maybe<toolbox::strref>& value) override { _writer.string(value); }
+  void openList() override { _writer.openList(); }
+  void openObject() override { _writer.openObject(); }
+  IWriter& property(const toolbox::strref& name) override { _writer.property(name); return *this; }
+  void close() override { _writer.close(); }
+  void end() override { _writer.end(); }
+  void fail() override { _writer.fail(); }
+  bool failed() const override { return _writer.failed(); }
+};
+
+/** Same as ForwardingWriter, but number literals are also forwarded as they are. */
+class LiteralForwardingWriter final : public ForwardingWriter {
+public:
+  using ForwardingWriter::ForwardingWriter;
+
+  void numberLiteral(const toolbox::strref& literal) override { _writer.numberLiteral(literal); }
+};
+
+template<typename Forwarding = ForwardingWriter, typename Write>
+static std::string forward(Write write, bool* failed = nullptr) {
+  return ::write([&](jsons::IWriter& w) { Forwarding forwarding {w}; write(forwarding); }, failed);
+}
+
+int main() {
+  CHECK(write([](jsons::IWriter& w) { w.number(UINT64_MAX); }) == "18446744073709551615");
+  CHECK(write([](jsons::IWriter& w) { w.number(uint64_t(INT64_MAX) + 1u); }) == "9223372036854775808");
+  CHECK(write([](jsons::IWriter& w) { w.number(INT64_MIN); }) == "-9223372036854775808");
+  CHECK(write([](jsons::IWriter& w) { w.number(UINT32_MAX); }) == "4294967295");
+  CHECK(write([](jsons::IWriter& w) { w.number(static_cast<int8_t>(-5)); }) == "-5");
+  CHECK(write([](jsons::IWriter& w) { w.number(static_cast<uint16_t>(65535)); }) == "65535");
+  CHECK(write([](jsons::IWriter& w) { w.number(0.5f); }) == "0.5");
+  // doubles are written with as few digits as needed to read them back (which
+  // may differ from the closest digits in the last place with 17 of them)
+  CHECK(write([](jsons::IWriter& w) {
+    w.openList(); w.number(0.1); w.number(-1234.5); w.number(1e15); w.number(1e-5); w.number(2.0 / 3.0); w.number(-0.0);
+    w.number(1.7976931348623157e308); w.number(-2.2250738585072014e-308); w.number(5e-324);
+  }) == "[0.1,-1234.5,1e+15,1e-05,0.6666666666666666,0,1.7976931348623158e+308,-2.2250738585072015e-308,4.94065645841247e-324]");
+  CHECK(write([](jsons::IWriter& w) { w.boolean(true); }) == "true");
+
+  // strings written in fragments are ended by end(), as are structures
+  bool failed = true;
+  CHECK(write([](jsons::IWriter& w) { w.escapedString("abc", true); }, &failed) == "\"abc\"");
+  CHECK(!failed);
+  CHECK(write([](jsons::IWriter& w) { w.openList(); w.escapedString("a", true); w.escapedString("b", true); }, &failed) == "[\"ab\"]");
+  CHECK(!failed);
+  CHECK(write([](jsons::IWriter& w) { w.openObject(); w.property("s").escapedString("x\\n", true); }, &failed) == "{\"s\":\"x\\n\"}");
+  CHECK(!failed);
+  write([](jsons::IWriter& w) { w.openList(); w.escapedString("a", true); w.close(); }, &failed);
+  CHECK(failed);
+
+  // raw values
+  CHECK(write([](jsons::IWriter& w) { w.openList(); w.raw("{\"a\":[1]}"); w.raw(" 2 "); }, &failed) == "[{\"a\":[1]}, 2 ]");
+  CHECK(!failed);
+  write([](jsons::IWriter& w) { w.openList(); w.raw(""); w.number(1); }, &failed);
+  CHECK(failed);
+  write([](jsons::IWriter& w) { w.raw(" \n"); }, &failed);
+  CHECK(failed);
+
+  // a SizeCounter counts exactly what is written
+  const auto document = [](jsons::IWriter& w) {
+    static const int32_t INTEGERS[] = {1, -20, 300};
+    static const toolbox::strref STRINGS[] = {"a\"b", "\\\n\t\x01"};
+    w.openObject();
+    w.property("na\"me").string("quote \" backslash \\ control \x1f newline \n unicode \xc3\xa4");
+    w.property("escaped").escapedString("x\\u0041", true);
+    w.escapedString("\\\"y");
+    w.property("raw").raw(" {\"a\":[1, 2]} ");
+    w.property("integers").list(INTEGERS, 3u);
+    w.property("strings").list(STRINGS, 2u);
+    w.property("number").number(-1.25);
+  };
+  CHECK(countsSize(document));
+  CHECK(countsSize<16u>(document));
+  const auto deep = [](jsons::IWriter& w) { w.openList(); w.number(1); w.openObject(); w.property("a").openList(); w.number(2); };
+  CHECK((countsSize<0u, 2u>(deep)));
+  CHECK((countsSize<16u, 2u>(deep)));
+
+  // the default implementations of lists write each value
+  static const int32_t INTEGERS[] = {1, -2, 3};
+  static const toolbox::strref STRINGS[] = {"a", "b\"c"};
+  static const bool BOOLEANS[] = {true, false};
+  CHECK(forward([](jsons::IWriter& w) { w.openList(); w.list(INTEGERS, 3u); w.list(STRINGS, 2u); w.list(BOOLEANS, 2u); w.list(INTEGERS, 0u); })
+    == write([](jsons::IWriter& w) { w.openList(); w.list(INTEGERS, 3u); w.list(STRINGS, 2u); w.list(BOOLEANS, 2u); w.list(INTEGERS, 0u); }));
+  CHECK(forward([](jsons::IWriter& w) { w.list(INTEGERS, 3u); }) == "[1,-2,3]");
+
+  // the default implementations of 64-bit integers and doubles write number literals
+  CHECK(forward<LiteralForwardingWriter>([](jsons::IWriter& w) { w.openList(); w.number(INT64_MIN); w.number(0.1); w.number(1e300); w.number(toolbox::Maybe<double>()); })
+    == write([](jsons::IWriter& w) { w.openList(); w.number(INT64_MIN); w.number(0.1); w.number(1e300); w.number(toolbox::Maybe<double>()); }));
+
+  // the default implementations of number literals and escaped strings and names write them decoded
+  CHECK(forward([](jsons::IWriter& w) { w.openList(); w.numberLiteral("-12"); w.numberLiteral("2.5"); w.numberLiteral("-0.125"); w.numberLiteral("-2147483648"); }, &failed)
+    == "[-12,2.5,-0.125,-2147483648]");
+  CHECK(!failed);
+  CHECK(forward([](jsons::IWriter& w) { w.openObject(); w.escapedProperty("a\\\"b").escapedString("x\\n\\u00e4\\/\\ud83d\\ude00"); w.escapedProperty("").escapedString(""); }, &failed)
+    == "{\"a\\\"b\":\"x\\n\xc3\xa4/\xf0\x9f\x98\x80\",\"\":\"\"}");
+  CHECK(!failed);
+  const std::string longest(jsons::IWriter::MAX_DECODED_LENGTH, 'x');
+  CHECK(forward([&](jsons::IWriter& w) { w.escapedString(longest.c_str()); }, &failed) == "\"" + longest + "\"");
+  CHECK(!failed);
+
+  // and fail the writer for what they cannot write
+  forward([](jsons::IWriter& w) { w.openList(); w.numberLiteral("x"); }, &failed);
+  CHECK(failed);
+  forward([](jsons::IWriter& w) { w.openList(); w.escapedString("a", true); w.escapedString("b"); }, &failed);
+  CHECK(failed);
+  forward([&](jsons::IWriter& w) { w.escapedString((longest + "\\n").c_str()); }, &failed);
+  CHECK(failed);
+  forward([&](jsons::IWriter& w) { w.openObject(); w.escapedProperty((longest + "x").c_str()).null(); }, &failed);
+  CHECK(failed);
+  forward([](jsons::IWriter& w) { w.openList(); w.raw("1"); }, &failed);
+  CHECK(failed);
+
+  return TEST_RESULT();
+}